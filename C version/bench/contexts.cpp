@@ -0,0 +1,72 @@
+/****************************************************************
+ * File: bench/contexts.cpp
+ * Times BIT_CHART against PREFIX_CHART on queries built the way
+ * the learner builds them: l ++ w ++ r for every context (l, r)
+ * of a few samples and every substring w of the samples
+ ****************************************************************
+ * Build from the "C version" directory:
+ *   g++ -std=c++11 -O2 -I. bench/contexts.cpp binaryio.cpp cachefile.cpp
+ *       cyk.cpp cykCBFG.cpp featuresets.cpp grammarfile.cpp grammars.cpp
+ *       membership.cpp prefixchart.cpp symbols.cpp types.cpp threadpool.cpp
+ *       valiant.cpp -o contexts
+ * Run:
+ *   contexts [nonterminals] [rules] [sample length]
+ * Output is CSV: engine,queries,ns_per_query
+ ****************************************************************/
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+
+#include "../cyk.h"
+#include "randomgrammar.h"
+
+using namespace::std;
+
+int main(int argc, char* argv[]){
+	unsigned int nt = argc > 1 ? atoi(argv[1]) : 64;
+	unsigned int rules = argc > 2 ? atoi(argv[2]) : 512;
+	unsigned int length = argc > 3 ? atoi(argv[3]) : 12;
+
+	mt19937 rng(1);
+	vector<symbol> sigma = fourTerminals();
+	vector<PLRule> PL;
+	vector<PRule> P;
+	randomGrammar(nt, rules, sigma, rng, PL, P);
+
+	vector<vector<symbol>> samples(3);
+	for (auto &s : samples)
+		for (unsigned int i = 0; i < length; i++)
+			s.push_back(sigma[rng() % sigma.size()]);
+
+	// Contexts outermost, as in FL and CK, so neighbouring queries share l
+	vector<vector<symbol>> queries;
+	for (auto &s : samples)
+		for (unsigned int i = 0; i <= s.size(); i++)
+			for (unsigned int j = i + 1; j <= s.size(); j++)
+				for (auto &t : samples)
+					for (unsigned int k = 0; k < t.size(); k++)
+						for (unsigned int m = k + 1; m <= t.size(); m++){
+							vector<symbol> q(s.begin(), s.begin() + i);
+							q.insert(q.end(), t.begin() + k, t.begin() + m);
+							q.insert(q.end(), s.begin() + j, s.end());
+							queries.push_back(q);
+						}
+
+	const char* names[] = { "BIT_CHART", "PREFIX_CHART" };
+	CFGEngine engines[] = { BIT_CHART, PREFIX_CHART };
+	unsigned int accepted[2] = { 0, 0 };
+
+	cout << "engine,queries,ns_per_query" << endl;
+	for (int e = 0; e < 2; e++){
+		CFGOracle oracle(engines[e]);
+		oracle.compile(PL, P);
+		auto t0 = chrono::steady_clock::now();
+		for (auto &q : queries)
+			accepted[e] += oracle.accepts(q, PL, P, 0);
+		double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - t0).count();
+		cout << names[e] << "," << queries.size() << "," << (long long)(ns / queries.size()) << endl;
+	}
+	if (accepted[0] != accepted[1])
+		cerr << "engines disagree: " << accepted[0] << " vs " << accepted[1] << endl;
+}
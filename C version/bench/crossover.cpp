@@ -0,0 +1,77 @@
+/****************************************************************
+ * File: bench/crossover.cpp
+ * Times the CFGOracle engines against each other as the sentence
+ * length grows, to find where VALIANT overtakes the CYK charts
+ ****************************************************************
+ * Build from the "C version" directory:
+ *   g++ -std=c++11 -O2 -I. bench/crossover.cpp binaryio.cpp cachefile.cpp
+ *       cyk.cpp cykCBFG.cpp featuresets.cpp grammarfile.cpp grammars.cpp
+ *       membership.cpp prefixchart.cpp symbols.cpp types.cpp threadpool.cpp
+ *       valiant.cpp -o crossover
+ * Run:
+ *   crossover [nonterminals] [rules] [max length]
+ * Output is CSV: engine,n,ns_per_query,queries
+ ****************************************************************/
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+
+#include "../cyk.h"
+#include "randomgrammar.h"
+
+using namespace::std;
+
+// Average ns per accepts() call over enough calls to fill about a tenth of a second
+double timeEngine(CFGOracle &oracle, const vector<vector<symbol>> &sentences,
+	const vector<PLRule> &PL, const vector<PRule> &P, unsigned int &queries)
+{
+	auto t0 = chrono::steady_clock::now();
+	double elapsed = 0;
+	queries = 0;
+	bool sink = false;
+	while (elapsed < 1e8 || queries < 3){
+		sink ^= oracle.accepts(sentences[queries % sentences.size()], PL, P, 0);
+		queries++;
+		elapsed = chrono::duration<double, nano>(chrono::steady_clock::now() - t0).count();
+	}
+	if (sink)
+		oracle.history.clear();
+	return elapsed / queries;
+}
+
+int main(int argc, char* argv[]){
+	unsigned int nt = argc > 1 ? atoi(argv[1]) : 64;
+	unsigned int rules = argc > 2 ? atoi(argv[2]) : 512;
+	unsigned int maxLength = argc > 3 ? atoi(argv[3]) : 512;
+
+	mt19937 rng(1);
+	vector<symbol> sigma = fourTerminals();
+	vector<PLRule> PL;
+	vector<PRule> P;
+	randomGrammar(nt, rules, sigma, rng, PL, P);
+
+	const char* names[] = { "LIST_CHART", "BIT_CHART", "VALIANT" };
+	CFGEngine engines[] = { LIST_CHART, BIT_CHART, VALIANT };
+	bool running[] = { true, true, true };
+
+	cout << "engine,n,ns_per_query,queries" << endl;
+	for (unsigned int n = 8; n <= maxLength; n *= 2){
+		vector<vector<symbol>> sentences(8);
+		for (auto &w : sentences)
+			for (unsigned int i = 0; i < n; i++)
+				w.push_back(sigma[rng() % sigma.size()]);
+		for (int e = 0; e < 3; e++){
+			if (!running[e])
+				continue;
+			CFGOracle oracle(engines[e]);
+			oracle.compile(PL, P);
+			oracle.accepts(sentences[0], PL, P, 0);	// warm up
+			unsigned int queries;
+			double ns = timeEngine(oracle, sentences, PL, P, queries);
+			cout << names[e] << "," << n << "," << (long long)ns << "," << queries << endl;
+			if (ns > 2e9)	// too slow to go any longer
+				running[e] = false;
+		}
+	}
+}
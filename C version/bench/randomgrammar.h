@@ -0,0 +1,44 @@
+/****************************************************************
+ * File: bench/randomgrammar.h
+ * Random grammars the benchmarks time the engines on
+ ****************************************************************/
+#ifndef _RANDOMGRAMMAR_
+#define _RANDOMGRAMMAR_
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../types.h"
+
+using namespace::std;
+
+// The terminals a, b, c and d, interned in that order
+inline vector<symbol> fourTerminals(){
+	vector<symbol> sigma;
+	for (unsigned int a = 0; a < 4; a++)
+		sigma.push_back(terminals.intern(string(1, 'a' + a)));
+	return sigma;
+}
+
+// Random CNF grammar over nt nonterminals and the terminals of sigma
+// Every terminal can be several nonterminals, so most chart cells fill up
+inline void randomGrammar(unsigned int nt, unsigned int rules, const vector<symbol> &sigma, mt19937 &rng,
+	vector<PLRule> &PL, vector<PRule> &P)
+{
+	for (unsigned int i = 0; i < nt * 2; i++){
+		PLRule r;
+		r.left = rng() % nt;
+		r.right = sigma[rng() % sigma.size()];
+		PL.push_back(r);
+	}
+	for (unsigned int i = 0; i < rules; i++){
+		PRule r;
+		r.left = rng() % nt;
+		r.one = rng() % nt;
+		r.two = rng() % nt;
+		P.push_back(r);
+	}
+}
+
+#endif
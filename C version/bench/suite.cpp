@@ -0,0 +1,235 @@
+/****************************************************************
+ * File: bench/suite.cpp
+ * Baseline timings of CFGOracle::accepts, CBFGOracle::accepts,
+ * g() and the whole learner, on the bundled grammars and on
+ * random grammars of a given size
+ ****************************************************************
+ * Build from the "C version" directory:
+ *   g++ -std=c++11 -O2 -I. bench/suite.cpp binaryio.cpp cachefile.cpp
+ *       checkpoint.cpp cyk.cpp cykCBFG.cpp featuresets.cpp grammarfile.cpp
+ *       grammars.cpp hypothesis.cpp learner.cpp membership.cpp
+ *       observation.cpp prefixchart.cpp symbols.cpp threadpool.cpp
+ *       types.cpp valiant.cpp -o suite -lpthread
+ * Run:
+ *   suite [--reps n] [--warmup n] [--quick] [grammar ...]
+ * The grammars are cfg0.txt cfg1.txt cfg2.txt if none are given.
+ * Every row is the median of reps timed runs after warmup untimed
+ * ones (5 and 1 by default).  --quick sweeps less and makes reps 3
+ * unless --reps is given.  The random grammars and strings come from a fixed seed,
+ * so two runs time the same work.
+ *   cfg_accepts    CFGOracle::accepts per engine, over sentence
+ *                  length on each grammar (random strings over its
+ *                  terminals) and over rule count on random grammars
+ *   cbfg_accepts   CBFGOracle::accepts of the hypothesis learned
+ *                  from each grammar's samples, over sentence length
+ *   g              the rules of g(K, F) made from scratch, with K and
+ *                  F as after the first samples samples, every cell
+ *                  answered from the oracle's history and an empty
+ *                  featureSets
+ *   learner        IIL over the first samples samples, from an empty
+ *                  history and featureSets; an operation is a whole
+ *                  run
+ * Output is CSV:
+ *   bench,grammar,variant,param,value,reps,ns_per_op,ops_per_s,peak_rss_kb
+ * peak_rss_kb is the process's high water mark so far (getrusage),
+ * so it only grows down the rows.
+ ****************************************************************/
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+#include "../featuresets.h"
+#include "../grammars.h"
+#include "../hypothesis.h"
+#include "../learner.h"
+#include "../observation.h"
+#include "randomgrammar.h"
+
+using namespace::std;
+
+unsigned int reps = 5, warmup = 1;
+
+// Peak resident set of the process so far in kB, 0 where getrusage is missing
+long peakRSS(){
+#ifdef _WIN32
+	return 0;
+#else
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	return usage.ru_maxrss;
+#endif
+}
+
+// Median ns per operation over the timed runs of op
+// op(run) does one run and returns how many operations it did.  Runs are numbered
+// from 0, the warmups first, so each run can be given its own input.
+template <class F>
+double measure(F op){
+	for (unsigned int r = 0; r < warmup; r++)
+		op(r);
+	vector<double> ns;
+	for (unsigned int r = 0; r < reps; r++){
+		auto t0 = chrono::steady_clock::now();
+		double ops = op(warmup + r);
+		ns.push_back(chrono::duration<double, nano>(chrono::steady_clock::now() - t0).count() / max(ops, 1.0));
+	}
+	sort(ns.begin(), ns.end());
+	return ns[ns.size() / 2];
+}
+
+void report(const string &bench, const string &grammar, const string &variant,
+	const string &param, unsigned int value, double ns)
+{
+	cout << bench << "," << grammar << "," << variant << "," << param << "," << value << ","
+		<< reps << "," << (long long)ns << "," << (ns > 0 ? 1e9 / ns : 0) << "," << peakRSS() << endl;
+}
+
+// One batch of random strings of length n over sigma for every run of measure()
+vector<vector<vector<symbol>>> randomBatches(unsigned int n, unsigned int batch,
+	const vector<symbol> &sigma, mt19937 &rng)
+{
+	vector<vector<vector<symbol>>> batches(warmup + reps, vector<vector<symbol>>(batch));
+	for (auto &b : batches)
+		for (auto &w : b)
+			for (unsigned int i = 0; i < n; i++)
+				w.push_back(sigma[rng() % sigma.size()]);
+	return batches;
+}
+
+// The terminals G's lexical rules use
+vector<symbol> alphabet(const vector<PLRule> &PL){
+	vector<symbol> sigma;
+	for (auto &r : PL)
+		if (find(sigma.begin(), sigma.end(), r.right) == sigma.end())
+			sigma.push_back(r.right);
+	return sigma;
+}
+
+const char* engineNames[] = { "LIST_CHART", "BIT_CHART", "VALIANT", "PREFIX_CHART" };
+const CFGEngine engines[] = { LIST_CHART, BIT_CHART, VALIANT, PREFIX_CHART };
+
+// Times every engine on the same batches, and returns which ones stayed under a
+// tenth of a second a query, so a sweep can leave the rest out of its next step
+vector<bool> timeEngines(const string &grammar, const vector<PLRule> &PL, const vector<PRule> &P,
+	symbol start, const string &param, unsigned int value,
+	const vector<vector<vector<symbol>>> &batches, const vector<bool> &running)
+{
+	vector<bool> keep(running);
+	for (int e = 0; e < 4; e++){
+		if (!running[e])
+			continue;
+		CFGOracle oracle(engines[e]);
+		oracle.compile(PL, P);
+		bool sink = false;
+		double ns = measure([&](unsigned int run){
+			for (auto &w : batches[run])
+				sink ^= oracle.accepts(w, PL, P, start);
+			return (double)batches[run].size();
+		});
+		if (sink)
+			oracle.history.clear();
+		report("cfg_accepts", grammar, engineNames[e], param, value, ns);
+		keep[e] = ns < 1e8;
+	}
+	return keep;
+}
+
+int main(int argc, char* argv[]){
+	bool quick = false, repsGiven = false;
+	vector<string> files;
+	for (int i = 1; i < argc; i++){
+		if (string(argv[i]) == "--reps" && i + 1 < argc){
+			reps = max(atoi(argv[++i]), 1);
+			repsGiven = true;
+		}
+		else if (string(argv[i]) == "--warmup" && i + 1 < argc)
+			warmup = max(atoi(argv[++i]), 0);
+		else if (string(argv[i]) == "--quick")
+			quick = true;
+		else
+			files.push_back(argv[i]);
+	}
+	if (quick && !repsGiven)
+		reps = 3;
+	if (files.empty())
+		files = { "cfg0.txt", "cfg1.txt", "cfg2.txt" };
+	vector<unsigned int> lengths = quick ? vector<unsigned int>{ 4, 16 } : vector<unsigned int>{ 4, 8, 16, 32, 64 };
+	vector<unsigned int> ruleCounts = quick ? vector<unsigned int>{ 128, 512 } : vector<unsigned int>{ 128, 512, 2048, 8192 };
+	unsigned int batch = quick ? 16 : 64;
+	mt19937 rng(1);
+
+	cout << "bench,grammar,variant,param,value,reps,ns_per_op,ops_per_s,peak_rss_kb" << endl;
+	for (auto &file : files){
+		CFG* target = extract((char*)file.c_str());
+		vector<symbol> sigma = alphabet(target->rules.PL);
+
+		vector<bool> running(4, true);
+		for (auto n : lengths)
+			running = timeEngines(file, target->rules.PL, target->rules.P, target->start, "n", n,
+				randomBatches(n, batch, sigma, rng), running);
+
+		// The hypothesis and the learner's sets after each number of samples
+		Learner learner(target);
+		vector<Checkpoint> after;
+		for (auto &w : target->samples){
+			learner.learn(w);
+			after.push_back(learner.state());
+		}
+		for (auto n : lengths){
+			auto batches = randomBatches(n, batch, sigma, rng);
+			double ns = measure([&](unsigned int run){
+				for (auto &w : batches[run])
+					learner.hypothesis().accepts(w);
+				return (double)batches[run].size();
+			});
+			report("cbfg_accepts", file, "CBFG", "n", n, ns);
+		}
+
+		vector<unsigned int> counts;
+		for (unsigned int k = 1; k < after.size() && !quick; k *= 2)
+			counts.push_back(k);
+		if (!after.empty())
+			counts.push_back(after.size());
+		for (auto k : counts){
+			const Checkpoint &c = after[k - 1];
+			double ns = measure([&](unsigned int){
+				featureSets.clear();
+				ObservationTable table(target);
+				table.setFeatures(c.F);
+				Hypothesis rules(table);
+				rules.update(c.K);
+				return 1.0;
+			});
+			report("g", file, "rules", "samples", k, ns);
+		}
+		for (auto k : counts){
+			double ns = measure([&](unsigned int){
+				target->oracle->history.clear();
+				featureSets.clear();
+				Learner run(target);
+				for (unsigned int i = 0; i < k; i++)
+					run.learn(target->samples[i]);
+				return 1.0;
+			});
+			report("learner", file, "IIL", "samples", k, ns);
+		}
+	}
+
+	// Random grammars with 32 nonterminals over 4 terminals, 32 token sentences
+	vector<symbol> sigma = fourTerminals();
+	vector<bool> running(4, true);
+	for (auto rules : ruleCounts){
+		vector<PLRule> PL;
+		vector<PRule> P;
+		randomGrammar(32, rules, sigma, rng, PL, P);
+		running = timeEngines("random", PL, P, 0, "rules", rules, randomBatches(32, batch, sigma, rng), running);
+	}
+}
@@ -0,0 +1,129 @@
+#ifndef _BINARYIO_
+#define _BINARYIO_
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "symbols.h"
+
+using namespace::std;
+
+// Helpers for the binary files (grammarfile.h, checkpoint.h): counts followed by
+// arrays of fixed size integers in native byte order, appended to a byte buffer and
+// read back through a Cursor over the mapped file
+
+inline void put(vector<char> &out, const void* p, size_t bytes){
+	out.insert(out.end(), (const char*)p, (const char*)p + bytes);
+}
+
+inline void put32(vector<char> &out, uint32_t x){
+	put(out, &x, sizeof(x));
+}
+
+inline void put64(vector<char> &out, uint64_t x){
+	put(out, &x, sizeof(x));
+}
+
+// A count, then the elements as they are in memory
+template <class T>
+void putArray(vector<char> &out, const vector<T> &v){
+	put32(out, v.size());
+	put(out, v.data(), v.size() * sizeof(T));
+}
+
+// Arrays meant to be used where they are in a mapped file start at a multiple of this
+// many bytes from the start of the file, which covers the alignment of every type written
+static const size_t ALIGNMENT = 8;
+
+// A count, then padding up to ALIGNMENT, then the elements as they are in memory
+// out must hold the whole file from its first byte
+template <class T>
+void putAligned(vector<char> &out, const T* p, size_t n){
+	put32(out, n);
+	out.resize((out.size() + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT, 0);
+	put(out, p, n * sizeof(T));
+}
+
+// Every name's length, then all of their characters
+void putNames(vector<char> &out, const SymbolTable &table);
+// Every string's length, then all of their symbols
+void putStrings(vector<char> &out, const vector<vector<symbol>> &ws);
+
+// Writes bytes to file.tmp and renames it over file, so a reader never sees half a file
+bool replaceFile(const string &file, const vector<char> &bytes);
+
+// The bytes of a whole file, mapped read-only and shared where there is mmap, read in
+// elsewhere
+class MappedFile{
+public:
+	MappedFile(const string &file);
+	~MappedFile();
+	MappedFile(const MappedFile &) = delete;	// owns the mapping
+	MappedFile &operator=(const MappedFile &) = delete;
+	const char* data() const { return bytes; }
+	size_t size() const { return length; }
+private:
+	const char* bytes;	// NULL if the file couldn't be read
+	size_t length;
+	vector<char> copy;
+};
+
+// Walks a file front to back; a read past the end clears ok and reads zeros from then on
+struct Cursor{
+	Cursor(const MappedFile &file)
+		: begin(file.data()), at(file.data()), end(file.data() + file.size()), ok(file.data() != NULL) {}
+	const char* begin;
+	const char* at;
+	const char* end;
+	bool ok;
+	bool take(void* to, size_t bytes){
+		if (!ok || (size_t)(end - at) < bytes)
+			return ok = false;
+		if (bytes > 0)
+			memcpy(to, at, bytes);
+		at += bytes;
+		return true;
+	}
+	uint32_t get32(){
+		uint32_t x = 0;
+		take(&x, sizeof(x));
+		return x;
+	}
+	uint64_t get64(){
+		uint64_t x = 0;
+		take(&x, sizeof(x));
+		return x;
+	}
+	template <class T>
+	void getArray(vector<T> &v){
+		uint32_t n = get32();
+		if (!ok || (size_t)(end - at) / sizeof(T) < n){
+			ok = false;
+			return;
+		}
+		v.resize(n);
+		take(v.data(), n * sizeof(T));
+	}
+	// An array written by putAligned, left in the file: p points at its n elements
+	template <class T>
+	void getAligned(const T* &p, size_t &n){
+		n = get32();
+		size_t pad = (ALIGNMENT - (at - begin) % ALIGNMENT) % ALIGNMENT;
+		if (!ok || (size_t)(end - at) < pad || (size_t)(end - at - pad) / sizeof(T) < n){
+			ok = false;
+			p = NULL;
+			n = 0;
+			return;
+		}
+		p = (const T*)(at + pad);
+		at += pad + n * sizeof(T);
+	}
+	// Interns the names in file order, ids[i] is the id of the file's symbol i
+	void getNames(SymbolTable &table, vector<symbol> &ids);
+	// Strings written by putStrings; a symbol outside ids clears ok
+	void getStrings(vector<vector<symbol>> &ws, const vector<symbol> &ids);
+};
+
+#endif
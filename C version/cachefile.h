@@ -0,0 +1,54 @@
+#ifndef _CACHEFILE_
+#define _CACHEFILE_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "membership.h"
+#include "symbols.h"
+
+using namespace::std;
+
+// Membership answers of one target grammar, kept on disk so later runs can reuse them
+//
+// The file is named after a hash of the grammar's rules and holds a header followed by
+// an append-only log of records: total size, answer, token count, then each token as
+// length and bytes.  Tokens are stored by name, since ids depend on the order a run
+// meets the terminals in; ones this run hasn't met yet are interned as they load, so
+// every answer is kept.
+//
+// open() maps the file and loads every complete record into a MembershipCache.
+// New answers are buffered by add() and written by flush() in one append.  Loading and
+// appending both hold a flock on the file, so several processes can share it.  Before
+// appending, flush() cuts off any tail a crashed writer left after the last whole
+// record, and a write that fails partway is cut back off, so records only ever follow
+// whole records.
+class CacheFile{
+public:
+	CacheFile();
+	~CacheFile();
+	CacheFile(const CacheFile &) = delete;	// owns the file descriptor
+	CacheFile &operator=(const CacheFile &) = delete;
+	// Opens dir/<grammar hash>.cache, creating it if needed, and loads it into cache
+	// Returns false (and stays closed) if the file can't be used
+	bool open(const string &dir, uint64_t grammar, MembershipCache &cache);
+	// The same with the file named in full
+	bool openFile(const string &file, uint64_t grammar, MembershipCache &cache);
+	bool isOpen() const { return fd >= 0; }
+	void add(const vector<symbol> &w, bool answer);
+	void flush();
+	size_t loaded() const { return records; }
+	const string &path() const { return name; }
+private:
+	int fd;
+	string name;
+	size_t records;
+	size_t end;		// the file holds whole records up to here
+	vector<char> pending;	// encoded records not yet written
+};
+
+// Order independent 64 bit hash of a grammar given as one string per rule
+uint64_t grammarHash(vector<string> rules);
+
+#endif
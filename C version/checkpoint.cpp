@@ -0,0 +1,69 @@
+#include "binaryio.h"
+#include "checkpoint.h"
+
+static const char MAGIC[8] = { 'I', 'I', 'L', 'S', 'T', 'A', 'T', 'E' };
+static const uint32_t VERSION = 2;	// bump when the layout changes
+
+// Contexts as the strings of their left sides, then of their right sides
+static void putContexts(vector<char> &out, const vector<context> &cs){
+	vector<vector<symbol>> lhs, rhs;
+	for (auto &c : cs){
+		lhs.push_back(c.lhs);
+		rhs.push_back(c.rhs);
+	}
+	putStrings(out, lhs);
+	putStrings(out, rhs);
+}
+
+static void getContexts(Cursor &in, vector<context> &cs, const vector<symbol> &ids){
+	vector<vector<symbol>> lhs, rhs;
+	in.getStrings(lhs, ids);
+	in.getStrings(rhs, ids);
+	if (lhs.size() != rhs.size()){
+		in.ok = false;
+		return;
+	}
+	cs.resize(lhs.size());
+	for (size_t i = 0; i < cs.size(); i++){
+		cs[i].lhs.swap(lhs[i]);
+		cs[i].rhs.swap(rhs[i]);
+	}
+}
+
+bool writeCheckpoint(const string &file, const Checkpoint &c){
+	vector<char> out;
+	put(out, MAGIC, sizeof(MAGIC));
+	put32(out, VERSION);
+	put64(out, c.grammar);
+	put64(out, c.targetSamples);
+	put64(out, c.streamLines);
+	put64(out, c.queries);
+	putNames(out, terminals);
+	putStrings(out, c.D);
+	putStrings(out, c.K);
+	putStrings(out, c.SubD);
+	putContexts(out, c.F);
+	putContexts(out, c.ConD);
+	return replaceFile(file, out);
+}
+
+bool readCheckpoint(const string &file, Checkpoint &c){
+	MappedFile map(file);
+	Cursor in(map);
+	char magic[sizeof(MAGIC)];
+	in.take(magic, sizeof(magic));
+	if (!in.ok || memcmp(magic, MAGIC, sizeof(MAGIC)) != 0 || in.get32() != VERSION)
+		return false;
+	c.grammar = in.get64();
+	c.targetSamples = in.get64();
+	c.streamLines = in.get64();
+	c.queries = in.get64();
+	vector<symbol> ids;
+	in.getNames(terminals, ids);
+	in.getStrings(c.D, ids);
+	in.getStrings(c.K, ids);
+	in.getStrings(c.SubD, ids);
+	getContexts(in, c.F, ids);
+	getContexts(in, c.ConD, ids);
+	return in.ok;
+}
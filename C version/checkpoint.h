@@ -0,0 +1,42 @@
+#ifndef _CHECKPOINT_
+#define _CHECKPOINT_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "types.h"
+
+using namespace::std;
+
+// Everything IIL needs to go on after the samples it has learned: the learner's sets and
+// how far it got through its input.  The oracle's answers are not saved with it but
+// appended as they are made to a CacheFile log (the --cache file, or file.answers next
+// to the checkpoint), so a checkpoint never writes an answer twice.
+//
+// The file starts with a magic and a format version, and is laid out like a binary
+// grammar (see binaryio.h).  Every terminal's name is saved, so a run that meets its
+// terminals in another order can still read it.  The table, rules and hypothesis are
+// not saved; they are rebuilt from K and F, with every cell answered from the history.
+struct Checkpoint{
+	Checkpoint()
+		: grammar(0), targetSamples(0), streamLines(0), queries(0) {}
+	uint64_t grammar;		// CFG::hash() of the target
+	uint64_t targetSamples;		// samples of the target's own learned
+	uint64_t streamLines;		// lines of the stream read, SampleReader::lineCount()
+	uint64_t queries;		// CFG::queries
+	vector<vector<symbol>> D;
+	vector<vector<symbol>> K;
+	vector<vector<symbol>> SubD;
+	vector<context> F;
+	vector<context> ConD;
+};
+
+// Saves c to file, replacing it with a rename so a run killed while saving leaves the
+// last checkpoint whole.  The answer log should be flushed first.
+bool writeCheckpoint(const string &file, const Checkpoint &c);
+// Loads a file written by writeCheckpoint into c
+// Returns false if the file can't be read or has another format version
+bool readCheckpoint(const string &file, Checkpoint &c);
+
+#endif
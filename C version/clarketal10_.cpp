@@ -1,12 +1,18 @@
+#include <algorithm>
+#include <cstdlib>
 #include <fstream>
 #include <iostream>
 #include <string>
 #include <time.h>
 #include <vector>
 
+#include "checkpoint.h"
 #include "cyk.h"
 #include "cykCBFG.h"
+#include "grammarfile.h"
 #include "grammars.h"
+#include "learner.h"
+#include "samplereader.h"
 
 using namespace::std;
 
@@ -14,121 +20,22 @@ using namespace::std;
 /* Utility / Print Functions *//////////////////////////////////
 ////////////////////////////////////////////////////////////////
 
-// Takes the input file and creates an CFG object for the target grammar
-CFG* extract(char* file){
-	if (file == NULL){
-		cout << "No input file given!" << endl;
-		exit(1);
-	}
-
-	ifstream input(file);
-	string line;
-
-	string start;
-	CFGRules rules;
-	vector<vector<string>> samples;
-
-	if (input.is_open())
-	{
-		enum test_data_types{ starter, lexical, nonlexical, sample} type;
-		type = starter;
-
-		while (getline(input, line)){
-			if (line == "start:"){
-				type = starter;
-				continue;
-			}
-			else if (line == "lexical:"){
-				type = lexical;
-				continue;
-			}
-			else if (line == "nonlexical:"){
-				type = nonlexical;
-				continue;
-			}
-			else if (line == "samples:"){
-				type = sample;
-				continue;
-			}
-
-			PLRule PL;
-			PRule P;
-			string temp = "";
-			int num = 0;
-
-			switch (type){
-			case starter:
-				start = line;
-				break;
-			case lexical:
-				unsigned int i;
-				for (i = 0; i < line.length() && line[i] != ','; i++);
-				PL.left = line.substr(0, i);
-				PL.right = line.substr(i+1, line.length() - i - 1);
-				rules.PL.push_back(PL);
-				break;
-			case nonlexical:
-				for (unsigned int i = 0; i < line.length(); i++){
-					if (line[i] != ',')
-						temp += line[i];
-					else{
-						switch (num){
-						case 0:
-							P.left = temp;
-							break;
-						case 1:
-							P.one = temp;
-							break;
-						}
-						num++;
-						temp = "";
-					}
-				}
-				P.two = temp;
-				rules.P.push_back(P);
-				break;
-			case sample:
-				vector<string> tempsample;
-				for (unsigned int i = 0; i < line.length(); i++){
-					if (line[i] != ' ')
-						temp += line[i];
-					else{
-						tempsample.push_back(temp);
-						temp = "";
-					}
-				}
-				tempsample.push_back(temp);
-				samples.push_back(tempsample);
-			}
-		}
-
-		input.close();
-
-		CFG* G = new CFG(start, rules, samples);
-		return G;
-	}
-	else {
-		cout << "Unable to open file" << endl;
-		return NULL;
-	}
-}
-
 /* Printing functions */
 // Print at the beginning of each new sample
-void printProcessing(vector<string> w){
+void printProcessing(vector<symbol> w){
 	cout << "Processing input: ";
 	for (unsigned int i = 0; i < w.size(); i++)
-		cout << w[i] + " ";
+		cout << terminals.name(w[i]) + " ";
 	cout << endl;
 }
 
 // Print the contents of D
-void printD(vector<vector<string>> D){
+void printD(vector<vector<symbol>> D){
 	string s = "D: ";
 	for (unsigned int i = 0; i < D.size(); i++){
 		s.append("\"");
 		for (unsigned int j = 0; j < D[i].size(); j++)
-			s.append(D[i][j] + " ");
+			s.append(terminals.name(D[i][j]) + " ");
 		s.pop_back();
 		s.append("\", ");
 	}
@@ -144,13 +51,13 @@ void printContextVector(vector<context> v){
 	for (unsigned int i = 0; i < v.size(); i++){
 		cout << "(";
 		for (unsigned int j = 0; j < v[i].lhs.size(); j++){
-			cout << v[i].lhs[j];
+			cout << terminals.name(v[i].lhs[j]);
 			if (j < v[i].lhs.size() - 1)
 				cout << " ";
 		}
 		cout << ", ";
 		for (unsigned int j = 0; j < v[i].rhs.size(); j++){
-			cout << v[i].rhs[j];
+			cout << terminals.name(v[i].rhs[j]);
 			if (j < v[i].rhs.size() - 1)
 				cout << " ";
 		}
@@ -160,12 +67,12 @@ void printContextVector(vector<context> v){
 }
 
 // Print a vector of substrings
-void printSubstringVector(vector<vector<string>> s){
+void printSubstringVector(vector<vector<symbol>> s){
 	cout << "Substrings: ";
 	for (unsigned int i = 0; i < s.size(); i++){
 		cout << "(";
 		for (unsigned int j = 0; j < s[i].size(); j++){
-			cout << s[i][j];
+			cout << terminals.name(s[i][j]);
 			if (j < s[i].size() - 1)
 				cout << " ";
 		}
@@ -178,187 +85,174 @@ void printSubstringVector(vector<vector<string>> s){
 /* Main part of algorithm */////////////////////////////////////
 ////////////////////////////////////////////////////////////////
 
-// Just like python version
-void addNEsubstrings(vector<vector<string>> &sofar, vector<string> w){
-	for (unsigned int i = 0; i < w.size(); i++){
-		for (unsigned int j = i; j <= w.size(); j++){
-			vector<string> temp;
-			for (unsigned int k = i; k < j; k++) // Python: s=w[i:j]
-				temp.push_back(w[k]);
-
-			if (!search(sofar, temp)) // If temp is not already in sofar, add it
-				sofar.push_back(temp);
-		}
+// Main Algorithm function
+// The target's own samples are learned first, then those of stream if there is one.
+// Streamed samples the target rejects are skipped, and queries are answered with
+// the hypothesis as it is at that point.
+// With a checkpoint file, the state is saved there every `every` learned samples and
+// at the end.  A run resumed from a checkpoint skips the samples and stream lines
+// it had already read.
+CBFG IIL(CFG* target, SampleReader* stream, vector<vector<symbol>> &D,
+	const Checkpoint* resume, const string &checkpoint, unsigned int every){
+	clock_t t0 = clock();
+	Learner learner(target);
+	uint64_t targetSamples = 0;	// target samples learned
+	uint64_t streamLines = 0;	// stream lines read before the checkpoint
+	unsigned int unsaved = 0;	// samples learned since the last checkpoint
+	if (resume){
+		learner.restore(*resume);
+		targetSamples = resume->targetSamples;
+		streamLines = resume->streamLines;
 	}
-}
 
-// Just like python vesion
-void addContexts(vector<context> &sofar, vector<string> w){
-	for (unsigned int i = 0; i < w.size(); i++){
-		for (unsigned int j = i + 1; j < w.size() + 1; j++){
-			context c;
-			for (unsigned int k = 0; k < i; k++)
-				c.lhs.push_back(w[k]);
-			for (unsigned int k = j; k < w.size(); k++)
-				c.rhs.push_back(w[k]);
+	auto save = [&](){
+		if (checkpoint.empty())
+			return;
+		Checkpoint c = learner.state();
+		c.grammar = target->hash();
+		c.targetSamples = targetSamples;
+		c.streamLines = stream ? stream->lineCount() : 0;
+		c.queries = target->queries;
+		target->oracle->store.flush();
+		if (!writeCheckpoint(checkpoint, c))
+			cout << "Unable to write checkpoint " << checkpoint << endl;
+		unsaved = 0;
+	};
+	auto learn = [&](const vector<symbol> &w){
+		printProcessing(w);
+		cout << (float)(clock() - t0) / CLOCKS_PER_SEC << " seconds" << endl;
+		learner.learn(w);
+		if (++unsaved >= every)
+			save();
+	};
+	while (targetSamples < target->samples.size()){
+		targetSamples++;
+		learn(target->samples[targetSamples - 1]);
+	}
 
-			if (!search(sofar, c))	// If c is not already in sofar, add it
-				sofar.push_back(c);
+	vector<symbol> w;
+	bool query;
+	while (stream && stream->lineCount() < streamLines && stream->next(w, query))
+		;	// read before the checkpoint was saved
+	while (stream && stream->next(w, query)){
+		if (query){
+			cout << (learner.hypothesis().accepts(w) ? "Hypothesis accepts:" : "Hypothesis rejects:");
+			for (auto s : w)
+				cout << " " << terminals.name(s);
+			cout << endl;
 		}
+		else if (!target->accepts(w)){
+			cout << "Skipping sample rejected by target grammar:";
+			for (auto s : w)
+				cout << " " << terminals.name(s);
+			cout << endl;
+		}
+		else
+			learn(w);
 	}
-}
 
-// Mostly like python version
-vector<context> FL(vector<context> F, vector<string> w, CFG* G){
-	vector<context> features;
-	for (unsigned int i = 0; i < F.size(); i++){
-		// odot operation:
-		vector<string> lur;
-		// Add left side of the context
-		for (unsigned int j = 0; j < F[i].lhs.size(); j++)
-			lur.push_back(F[i].lhs[j]);
-		// Add string
-		for (unsigned int j = 0; j < w.size(); j++)
-			lur.push_back(w[j]);
-		// Add right side of context
-		for (unsigned int j = 0; j < F[i].rhs.size(); j++)
-			lur.push_back(F[i].rhs[j]);
+	save();
+	cout << endl << (float)(clock() - t0) / CLOCKS_PER_SEC << " seconds" << endl << endl;
 
-		// Test if lur is in language
-		if ((G->oracle->checkHistory(lur) == -1 && G->accepts(lur))
-			|| G->oracle->checkHistory(lur) == 1)
-			features.push_back(F[i]);
-	}
-	return features;
+	D = learner.samples();
+	return learner.hypothesis();
 }
 
-// Also mostly like python version
-CBFG g(vector<vector<string>> K, vector<context> F, CFG* target){
-	vector<PLCRule> PL;
-	vector<PCRule> P;
-
-	for (unsigned int i = 0; i < K.size(); i++){
-		vector<string> w = K[i];
-		vector<context> lhs = FL(F, w, target); // All the valid contexts of w
-		if (w.size() == 1){	// Lexical rule
-			string rhs = w[0];
-			PLCRule rule;
-			rule.c = lhs;
-			rule.s = rhs;
-			if (!search(PL, rule))	// Prevent redundancies
-				PL.push_back(rule);
+// clarketal10_ grammar.txt [--cache dir] [--cache-limit mb] [--stream file]
+//	[--checkpoint file] [--checkpoint-every n] [--resume file]
+// clarketal10_ grammar.txt --write-binary grammar.bin
+// The grammar may be text or binary; --write-binary only converts it to binary
+// With --cache, oracle answers are read from and added to a file in dir shared by
+// every run on the same target grammar
+// --cache-limit sets the megabytes the oracle's history of answers may take in memory
+// (256 by default); past it the answers least recently used are dropped
+// With --stream, more samples are read from file (- for stdin) one line at a time
+// after the grammar's own, and learned as they come (see SampleReader)
+// With --checkpoint, the learner's state is saved to file every n learned samples (10 by
+// default) and at the end, and the oracle's answers are added to file.answers as they
+// are made (to the cache instead, with --cache).  --resume starts from the state saved
+// in file, given the same grammar and stream, and goes on saving to it.
+// If file doesn't exist yet the run starts from the beginning, so a job that may be
+// stopped can always be started with --resume.
+int main(int argc, char* argv[]){
+	CFG* target = extract(argv[1]);
+	SampleReader* stream = NULL;
+	for (int i = 2; i + 1 < argc; i++)
+		if (string(argv[i]) == "--write-binary"){
+			if (!writeBinaryGrammar(argv[i + 1], *target)){
+				cout << "Unable to write " << argv[i + 1] << endl;
+				exit(1);
+			}
+			cout << "Wrote " << argv[i + 1] << endl;
+			return 0;
 		}
-		else {	// Nonlexical rule
-			for (unsigned int j = 1; j < w.size(); j++){
-				vector<string> wa;
-				vector<string> wb;
-				for (unsigned int k = 0; k < j; k++)
-					wa.push_back(w[k]);
-				for (unsigned int k = j; k < w.size(); k++)
-					wb.push_back(w[k]);
-				vector<context> fl1 = FL(F, wa, target);
-				vector<context> fl2 = FL(F, wb, target);
-				PCRule rule;
-				rule.lhs = lhs;
-				rule.rhs1 = fl1;
-				rule.rhs2 = fl2;
-				if (!search(P, rule))	// Prevent redundancies
-					P.push_back(rule);
+		else if (string(argv[i]) == "--cache-limit"){
+			int mb = atoi(argv[i + 1]);
+			if (mb < 1){
+				cout << "--cache-limit must be a number of at least 1" << endl;
+				exit(1);
 			}
+			target->oracle->history.setLimit((size_t)mb << 20);
 		}
-	}
-
-	CBFGRules rules;
-	rules.PL = PL;
-	rules.P = P;
-	CBFG Ghat = CBFG(rules);
-	return Ghat;
-}
-
-// Just like python version
-bool notDinLG(vector<vector<string>> D, CBFG G){
-	for (unsigned int i = 0; i < D.size(); i++)
-		if (!G.accepts(D[i]))
-			return true;
-	return false;
-}
-
-// Just like python version
-bool reallyLongCond(vector<vector<string>> SubD, vector<vector<string>> K,
-	vector<context> ConD, vector<context> F, CFG* G){
-	for (unsigned int i = 0; i < SubD.size(); i++){
-		vector<context> FLi = FL(F, SubD[i], G);
-		for (unsigned int j = 0; j < K.size(); j++){
-			vector<context> FLj = (FL(F, K[i], G));
-			if (subset(FLj, FLi))
-				for (unsigned int k = 0; k < ConD.size(); k++){
-				// The following 10 lines are the same as the 2 lines in python (stupid c++)
-				// We just Odot (insert) the given string from K with the context from ConD
-					vector<string> lur;
-					// Add left side of the context
-					for (unsigned int l = 0; l < ConD[k].lhs.size(); l++)
-						lur.push_back(ConD[k].lhs[l]);
-					// Add string
-					for (unsigned int l = 0; l < K[j].size(); l++)
-						lur.push_back(K[j][l]);
-					// Add right side of context
-					for (unsigned int l = 0; l < ConD[k].rhs.size(); l++)
-						lur.push_back(ConD[k].rhs[l]);
-					// Test if lur is in language
-
-					if ((G->oracle->checkHistory(lur) == -1 && G->accepts(lur))
-						|| G->oracle->checkHistory(lur) == 1)
-						return true;
-				}
+	Checkpoint* resume = NULL;
+	string checkpoint;
+	unsigned int every = 10;
+	for (int i = 2; i + 1 < argc; i++)
+		if (string(argv[i]) == "--cache"){
+			if (target->oracle->store.open(argv[i + 1], target->hash(), target->oracle->history))
+				cout << "Loaded " << target->oracle->store.loaded() << " answers from "
+					<< target->oracle->store.path() << endl << endl;
+			else
+				cout << "Can't use the cache in " << argv[i + 1] << endl << endl;
 		}
-	}
-	return false;
-}
-
-// Main Algorithm function
-CBFG IIL(CFG* target){
-	clock_t t0 = clock();
-	vector<vector<string>> K;
-	vector<vector<string>> D;
-	vector<context> F;
-	vector<context> ConD;
-	vector<vector<string>> SubD;
-
-	CBFG Ghat = g(K, F, target);
-
-	for (unsigned int i = 0; i < target->samples.size(); i++){
-		vector<string> w = target->samples[i];
-		printProcessing(w);
-		cout << (float)(clock() - t0) / CLOCKS_PER_SEC << " seconds" << endl;
-		D.push_back(w);
-		// printD(D);
-		addContexts(ConD, w);
-		// printContextVector(ConD);
-		addNEsubstrings(SubD, w);
-		// printSubstringVector(SubD);
-		if (notDinLG(D, Ghat)){
-			K = SubD;
-			F = ConD;
+		else if (string(argv[i]) == "--stream"){
+			stream = new SampleReader(argv[i + 1]);
+			if (!stream->isOpen()){
+				cout << "Unable to open " << argv[i + 1] << endl;
+				exit(1);
+			}
 		}
-		else if (reallyLongCond(SubD, K, ConD, F, target))
-			F = ConD;
-
-		Ghat = g(K, F, target);
-		// Ghat.print();
+		else if (string(argv[i]) == "--checkpoint")
+			checkpoint = argv[i + 1];
+		else if (string(argv[i]) == "--checkpoint-every")
+			every = max(atoi(argv[i + 1]), 1);
+		else if (string(argv[i]) == "--resume"){
+			if (checkpoint.empty())
+				checkpoint = argv[i + 1];
+			if (!ifstream(argv[i + 1]).is_open()){
+				cout << "No checkpoint in " << argv[i + 1] << " yet, starting from the first sample" << endl << endl;
+				continue;
+			}
+			resume = new Checkpoint();
+			if (!readCheckpoint(argv[i + 1], *resume)){
+				cout << "Unable to resume from " << argv[i + 1] << endl;
+				exit(1);
+			}
+			if (resume->grammar != target->hash()){
+				cout << argv[i + 1] << " was saved from another grammar" << endl;
+				exit(1);
+			}
+			target->queries = resume->queries;
+			cout << "Resuming after " << resume->D.size() << " samples from " << argv[i + 1] << endl << endl;
+		}
+	CacheFile &store = target->oracle->store;
+	if (!checkpoint.empty() && !store.isOpen()){
+		if (!store.openFile(checkpoint + ".answers", target->hash(), target->oracle->history))
+			cout << "Can't keep the oracle's answers in " << checkpoint << ".answers" << endl << endl;
+		else if (store.loaded() > 0)
+			cout << "Loaded " << store.loaded() << " answers from " << store.path() << endl << endl;
 	}
-
-	cout << endl << (float)(clock() - t0) / CLOCKS_PER_SEC << " seconds" << endl << endl;
-
-	return Ghat;
-}
-
-int main(int argc, char* argv[]){
-	CFG* target = extract(argv[1]);
 	target->print();
 	target->checkSamples();
-	CBFG Ghat = IIL(target);
+	vector<vector<symbol>> D;
+	CBFG Ghat = IIL(target, stream, D, resume, checkpoint, every);
 	Ghat.print();
 	cout << endl;
-	Ghat.checkSamples(target->samples);
+	Ghat.checkSamples(D);
 	cout << endl << target->queries << " queries to oracle" << endl;
-}
\ No newline at end of file
+	cout << target->oracle->history.size() << " strings in the oracle's history, "
+		<< target->oracle->history.hitRate() * 100 << "% of lookups answered from it" << endl;
+	target->oracle->store.flush();
+	delete stream;
+	delete resume;
+}
@@ -4,17 +4,18 @@
 #include "cyk.h"
 
 // Prints the cyk chart for debugging purposes
-void printChart(vector<string>** chart, unsigned int size){
+void printChart(ListChart<vector<symbol>> &chart, unsigned int size){
 	for (unsigned int i = 0; i <= size; i++){
 		for (unsigned int x = 0; x < (i)* 6; x++)
 			cout << " ";
 		for (unsigned int j = i + 1; j <= size; j++){
+			const vector<symbol> &cell = chart.cell(i, j);
 			string temp;
-			if (chart[i][j].size() != 0)
-				temp = chart[i][j][0];
-			for (unsigned int k = 1; k < chart[i][j].size(); k++){
+			if (cell.size() != 0)
+				temp = to_string(cell[0]);
+			for (unsigned int k = 1; k < cell.size(); k++){
 				temp += ",";
-				temp += chart[i][j][k];
+				temp += to_string(cell[k]);
 			}
 			cout << setw(4) << temp << ": ";
 		}
@@ -22,72 +23,287 @@ void printChart(vector<string>** chart, unsigned int size){
 	}
 }
 
+CFGOracle::CFGOracle(CFGEngine e)
+	: engine(e), workspaces(1) {}
+
 // Just like python version
-void CFGOracle::initializeChart(vector<string> w, const vector<PLRule> PL, vector<string>** chart){
+void CFGOracle::initializeChart(const vector<symbol> &w, const vector<PLRule> &PL, ListChart<vector<symbol>> &chart){
 	for (unsigned int i = 0; i < w.size(); i++){
 		for (unsigned int j = 0; j < PL.size(); j++){
 			if (w[i] == PL[j].right)
-				chart[i][i + 1].push_back(PL[j].left);
+				chart.cell(i, i + 1).push_back(PL[j].left);
 		}
 	}
 }
 
 // Just like python version
-void CFGOracle::closeChart(const vector<PRule> P, vector<string>** chart, unsigned int n){
+void CFGOracle::closeChart(const vector<PRule> &P, unsigned int n, ListChart<vector<symbol>> &chart){
 	for (unsigned int width = 1; width <= n; width++){
 		for (unsigned int start = 0; start <= n-width; start++){
 			unsigned int end = start + width;
+			vector<symbol> &cell = chart.cell(start, end);
 			for (unsigned int mid = start + 1; mid < end; mid++){
+				const vector<symbol> &left = chart.cell(start, mid);
+				const vector<symbol> &right = chart.cell(mid, end);
 				for (unsigned int i = 0; i < P.size(); i++){
-					if (search(chart[start][mid], P[i].one)
-						&& search(chart[mid][end], P[i].two)
-						&& !search(chart[start][end], P[i].left)) // Stops redundacies
-						chart[start][end].push_back(P[i].left);
+					if (search(left, P[i].one)
+						&& search(right, P[i].two)
+						&& !search(cell, P[i].left)) // Stops redundacies
+						cell.push_back(P[i].left);
 				}
 			}
 		}
 	}
 }
 
-bool CFGOracle::accepts(const vector<string> w, vector<PLRule> PL, vector<PRule> P, string start){
+bool CFGOracle::acceptsList(const vector<symbol> &w, const vector<PLRule> &PL, const vector<PRule> &P, symbol start,
+	ListChart<vector<symbol>> &chart)
+{
 	unsigned int n = w.size();
-	vector<string>** chart = new vector<string>*[n+1];	// Chart is dynamically allocated 2D array
-	for (unsigned int i = 0; i <= n; ++i)
-		chart[i] = new vector<string>[n + 1];
+	if (n == 0)
+		return false;
+	chart.reset(n);	// Reuses the cells of earlier queries
 
 	initializeChart(w, PL, chart);
-	closeChart(P, chart, n);
+	closeChart(P, n, chart);
 
 	// printChart(chart, n);
 
 	// Is the top left cell the start symbol?
-	bool success = search(chart[0][n], start) ? true : false;
+	return search(chart.cell(0, n), start);
+}
 
-	for (unsigned int i = 0; i <= n; ++i)	// Delete the dynamically allocated array from memory
-		delete [] chart[i];
-	delete [] chart;
+// Makes terminals with the same {A} share one copy of it
+// A lexicon of many words in a few classes then keeps one set per class
+static void shareLexicalSets(GrammarTables &tables, unsigned int W){
+	size_t bytes = W * sizeof(word);
+	unordered_map<string, unsigned int> offsets;
+	vector<word> sets;
+	for (auto &offset : tables.lexicon){
+		if (offset == GrammarIndex::NONE)
+			continue;
+		const word* As = &tables.lexicalSets[offset];
+		auto it = offsets.emplace(string((const char*)As, bytes), sets.size()).first;
+		if (it->second == sets.size())	// a set not seen before
+			sets.insert(sets.end(), As, As + W);
+		offset = it->second;
+	}
+	tables.lexicalSets.swap(sets);
+}
 
-	// add the string to the oracle's call history
-	string s;
-	for (unsigned int i = 0; i < w.size(); i++)
-		s += w[i];
-	history.emplace(s, success);
+// Lays out (B, C) -> offset as GrammarIndex::pairs, with at least twice as many slots
+static vector<PairSlot> pairTable(const unordered_map<uint64_t, unsigned int> &pairs){
+	size_t size = 0;
+	if (pairs.size() > 0)
+		for (size = 2; size < 2 * pairs.size(); size *= 2);
+	PairSlot empty = { EMPTY_PAIR, 0, 0 };
+	vector<PairSlot> table(size, empty);
+	for (auto &p : pairs){
+		size_t i = pairSlot(p.first, size - 1);
+		while (table[i].key != EMPTY_PAIR)
+			i = (i + 1) & (size - 1);
+		table[i].key = p.first;
+		table[i].parents = p.second;
+	}
+	return table;
+}
 
-	return success;
+// Builds the lexicon and binary rule lookup tables for a CFG
+GrammarIndex buildIndex(const vector<PLRule> &PL, const vector<PRule> &P){
+	GrammarIndex index;
+	for (unsigned int i = 0; i < PL.size(); i++)
+		index.nonterminals = max(index.nonterminals, PL[i].left + 1);
+	for (unsigned int i = 0; i < P.size(); i++)
+		index.nonterminals = max(index.nonterminals, max(P[i].left, max(P[i].one, P[i].two)) + 1);
+	unsigned int W = index.ntWords = bitWords(index.nonterminals);
+	shared_ptr<GrammarTables> tables = make_shared<GrammarTables>();
+	GrammarTables &t = *tables;
+
+	for (unsigned int i = 0; i < PL.size(); i++){
+		symbol a = PL[i].right;
+		if (a >= t.lexicon.size())
+			t.lexicon.resize(a + 1, GrammarIndex::NONE);
+		if (t.lexicon[a] == GrammarIndex::NONE){	// First rule with this terminal
+			t.lexicon[a] = t.lexicalSets.size();
+			t.lexicalSets.resize(t.lexicon[a] + W, 0);
+		}
+		setBit(&t.lexicalSets[t.lexicon[a]], PL[i].left);
+	}
+	shareLexicalSets(t, W);
+
+	unordered_map<uint64_t, unsigned int> pairs;
+	vector<vector<BinaryEntry>> byLeft(index.nonterminals);
+	for (unsigned int i = 0; i < P.size(); i++){
+		uint64_t key = (uint64_t)P[i].one << 32 | P[i].two;
+		auto it = pairs.find(key);
+		if (it == pairs.end()){	// First rule with this (B, C)
+			unsigned int offset = t.parentSets.size();
+			t.parentSets.resize(offset + W, 0);
+			it = pairs.emplace(key, offset).first;
+			BinaryEntry e;
+			e.right = P[i].two;
+			e.parents = offset;
+			byLeft[P[i].one].push_back(e);
+		}
+		setBit(&t.parentSets[it->second], P[i].left);
+	}
+	t.pairs = pairTable(pairs);
+	for (auto &entries : byLeft){
+		t.firstEntry.push_back(t.entries.size());
+		t.entries.insert(t.entries.end(), entries.begin(), entries.end());
+	}
+	t.firstEntry.push_back(t.entries.size());
+	index.use(tables);
+	return index;
 }
 
-// Returns -1 if w has not been called
-// If w has been called, it returns its value (true/false)
-int CFGOracle::checkHistory(vector<string> w){
-	// string vectors have to be converted into a single, concatenated string
-	string s;
-	for (unsigned int i = 0; i < w.size(); i++)
-		s += w[i];
+const unsigned int GrammarIndex::NONE;
+
+void GrammarIndex::use(const shared_ptr<const GrammarTables> &tables){
+	lexicon = tables->lexicon;
+	lexicalSets = tables->lexicalSets;
+	pairs = tables->pairs;
+	firstEntry = tables->firstEntry;
+	entries = tables->entries;
+	parentSets = tables->parentSets;
+	storage = tables;
+}
 
+// {A | A -> a}, or NULL if no rule derives a
+const word* GrammarIndex::lexical(symbol a) const{
+	if (a >= lexicon.size() || lexicon[a] == NONE)
+		return NULL;
+	return &lexicalSets[lexicon[a]];
+}
+
+// {A | A -> B C}, or NULL if no rule has these children
+const word* GrammarIndex::parents(symbol B, symbol C) const{
+	if (pairs.size() == 0)
+		return NULL;
+	uint64_t key = (uint64_t)B << 32 | C;
+	size_t mask = pairs.size() - 1;
+	for (size_t i = pairSlot(key, mask);; i = (i + 1) & mask){
+		if (pairs[i].key == key)
+			return &parentSets[pairs[i].parents];
+		if (pairs[i].key == EMPTY_PAIR)
+			return NULL;
+	}
+}
+
+void CFGOracle::compile(const vector<PLRule> &PL, const vector<PRule> &P){
+	compile(buildIndex(PL, P));
+}
+
+void CFGOracle::compile(GrammarIndex built){
+	index = move(built);
+	// A recognizer's pairs come from the index it was made with
+	for (auto &work : workspaces)
+		work.valiant.reset();
+	prefixChart.clear();
+}
+
+// Same chart as acceptsList, but a cell is ntWords words with one bit per nonterminal
+// A split point walks the (C, {A}) entries of each B in the left cell and ORs in {A}
+// when C is in the right cell.  If the two cells are small compared to the number of
+// those entries, it looks up every (B, C) pair in the pair index instead.
+bool CFGOracle::acceptsBits(const vector<symbol> &w, symbol start, BitChart &chart){
+	unsigned int n = w.size();
+	unsigned int W = index.ntWords;
+	if (n == 0 || start >= index.nonterminals)
+		return false;
+	chart.reset(n, W);	// Reuses the storage of earlier queries
 
-	unordered_map<string, bool>::const_iterator it = history.find(s);
-	if (it == history.end())
-		return -1;
+	for (unsigned int i = 0; i < n; i++){
+		const word* As = index.lexical(w[i]);
+		if (As != NULL)
+			orBits(chart.cell(i, i + 1), As, W);
+	}
+
+	for (unsigned int width = 1; width <= n; width++){
+		for (unsigned int start = 0; start <= n - width; start++){
+			unsigned int end = start + width;
+			word* cell = chart.cell(start, end);
+			for (unsigned int mid = start + 1; mid < end; mid++){
+				unsigned int lsize = chart.count(start, mid), rsize = chart.count(mid, end);
+				if (lsize == 0 || rsize == 0)
+					continue;
+				const word* l = chart.cell(start, mid);
+				const word* r = chart.cell(mid, end);
+				if (lsize * rsize < chart.fan(start, mid)){
+					forEachBit(l, W, [&](unsigned int B){
+						forEachBit(r, W, [&](unsigned int C){
+							const word* As = index.parents(B, C);
+							if (As)
+								orBits(cell, As, W);
+						});
+					});
+				}
+				else{
+					forEachBit(l, W, [&](unsigned int B){
+						for (const BinaryEntry &e : index.byLeft(B))
+							if (testBit(r, e.right))
+								orBits(cell, &index.parentSets[e.parents], W);
+					});
+				}
+			}
+			unsigned int &size = chart.count(start, end), &fan = chart.fan(start, end);
+			forEachBit(cell, W, [&](unsigned int B){
+				size++;
+				fan += index.byLeft(B).size();
+			});
+		}
+	}
+
+	return testBit(chart.cell(0, n), start);
+}
+
+bool CFGOracle::accepts(const vector<symbol> &w, const vector<PLRule> &PL, const vector<PRule> &P, symbol start,
+	Workspace &work)
+{
+	bool success;
+	if (engine == BIT_CHART)
+		success = acceptsBits(w, start, work.bitChart);
+	else if (engine == VALIANT){
+		success = false;
+		if (w.size() > 0 && start < index.nonterminals){
+			if (!work.valiant)
+				work.valiant.reset(new ValiantRecognizer(index));
+			work.valiant->parse(w, work.valiantTop);
+			success = testBit(work.valiantTop.data(), start);
+		}
+	}
+	else if (engine == PREFIX_CHART)
+		success = w.size() > 0 && start < index.nonterminals
+			&& testBit(prefixChart.parse(w, index), start);
 	else
-		return it->second;
-}
\ No newline at end of file
+		success = acceptsList(w, PL, P, start, work.listChart);
+
+	return success;
+}
+
+bool CFGOracle::accepts(const vector<symbol> &w, const vector<PLRule> &PL, const vector<PRule> &P, symbol start){
+	return accepts(w, PL, P, start, workspaces[0]);
+}
+
+vector<word> CFGOracle::acceptsBatch(const vector<const vector<symbol>*> &ws, const vector<PLRule> &PL,
+	const vector<PRule> &P, symbol start, ThreadPool &pool)
+{
+	vector<char> answers(ws.size());
+	if (engine == PREFIX_CHART){
+		for (size_t i = 0; i < ws.size(); i++)
+			answers[i] = accepts(*ws[i], PL, P, start);
+	}
+	else{
+		if (workspaces.size() < pool.size())
+			workspaces.resize(pool.size());
+		pool.parallelFor(ws.size(), [&](unsigned int worker, size_t i){
+			answers[i] = accepts(*ws[i], PL, P, start, workspaces[worker]);
+		});
+	}
+
+	vector<word> result(bitWords(ws.size()), 0);
+	for (size_t i = 0; i < ws.size(); i++)
+		if (answers[i])
+			setBit(result.data(), i);
+	return result;
+}
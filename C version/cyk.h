@@ -1,22 +1,66 @@
 #ifndef _CYK_
 #define _CYK_
 
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
+#include "bitset.h"
+#include "cachefile.h"
+#include "chart.h"
 #include "types.h"
 #include "grammars.h"
+#include "membership.h"
+#include "prefixchart.h"
+#include "threadpool.h"
+#include "valiant.h"
+
+// How CFGOracle fills its chart
+//   LIST_CHART: each cell is a vector of nonterminals, every rule is tried at every split
+//   BIT_CHART:  each cell is a bitset over nonterminal ids, splits are combined with word-wide AND/OR
+//   VALIANT:    the chart is closed by boolean matrix multiplication (see valiant.h),
+//               which wins over BIT_CHART on long sentences
+//   PREFIX_CHART: BIT_CHART filled column by column, reusing the columns of earlier
+//               queries that start the same way (see prefixchart.h)
+enum CFGEngine{ LIST_CHART, BIT_CHART, VALIANT, PREFIX_CHART };
+
+// Builds the lexicon and binary rule lookup tables for a CFG
+GrammarIndex buildIndex(const vector<PLRule> &PL, const vector<PRule> &P);
 
 class CFG;
 class CFGOracle{
 public:
-	bool accepts(const vector<string> w, vector<PLRule> PL, vector<PRule> P, string start);
-	unordered_map<string, bool> history;
-	int checkHistory(vector<string> w);
+	CFGOracle(CFGEngine e = BIT_CHART);
+	void compile(const vector<PLRule> &PL, const vector<PRule> &P);
+	void compile(GrammarIndex built);	// takes an index buildIndex already made
+	bool accepts(const vector<symbol> &w, const vector<PLRule> &PL, const vector<PRule> &P, symbol start);
+	// Parses every string of ws on the threads of pool, bit i of the result is ws[i]'s answer
+	// PREFIX_CHART shares one trie, so its batches are parsed in order on the calling thread
+	vector<word> acceptsBatch(const vector<const vector<symbol>*> &ws, const vector<PLRule> &PL,
+		const vector<PRule> &P, symbol start, ThreadPool &pool = sharedPool());
+	MembershipCache history;	// answers of earlier queries, kept by CFG::accepts
+	CacheFile store;		// the same answers on disk, if a cache directory was given
+	CFGEngine engine;
 private:
-	void initializeChart(vector<string> w, const vector<PLRule> PL, vector<string>** chart);
-	void closeChart(const vector<PRule> P, vector<string>** chart, unsigned int n);
+	// Charts of one thread
+	// They are kept between queries and only grow, so steady-state queries don't allocate
+	struct Workspace{
+		ListChart<vector<symbol>> listChart;
+		BitChart bitChart;
+		unique_ptr<ValiantRecognizer> valiant;	// made on first use
+		vector<word> valiantTop;
+	};
+	void initializeChart(const vector<symbol> &w, const vector<PLRule> &PL, ListChart<vector<symbol>> &chart);
+	void closeChart(const vector<PRule> &P, unsigned int n, ListChart<vector<symbol>> &chart);
+	bool acceptsList(const vector<symbol> &w, const vector<PLRule> &PL, const vector<PRule> &P, symbol start,
+		ListChart<vector<symbol>> &chart);
+	bool acceptsBits(const vector<symbol> &w, symbol start, BitChart &chart);
+	bool accepts(const vector<symbol> &w, const vector<PLRule> &PL, const vector<PRule> &P, symbol start,
+		Workspace &work);
+	GrammarIndex index;	// lookup tables for the bit chart (filled by compile)
+	vector<Workspace> workspaces;	// one per pool thread, accepts() uses the first
+	PrefixChart prefixChart;
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -2,12 +2,13 @@
 #include <iomanip>
 
 #include "cykCBFG.h"
+#include "featuresets.h"
 
-// Prints the cykCBFG chart for debugging purposes
-void printChart(vector<vector<context>>** chart, unsigned int size){
+// Prints the number of features in each cell of the cykCBFG chart for debugging purposes
+void printChart(BitChart &chart, unsigned int W, unsigned int size){
 	for (unsigned int i = 0; i <= size; i++){
-		for (unsigned int j = i; j <= size; j++){
-			int x = chart[i][j].size();
+		for (unsigned int j = i + 1; j <= size; j++){
+			int x = countBits(chart.cell(i, j), W);
 			cout << x;
 		}
 		cout << endl;
@@ -15,52 +16,125 @@ void printChart(vector<vector<context>>** chart, unsigned int size){
 }
 
 CBFGOracle::CBFGOracle(CBFG* G)
-	: parent(G) {}
+	: parent(G), W(0), empty(-1) {}
 
-void CBFGOracle::initializeChart(vector<string> w, vector<PLCRule> PL, vector<vector<context>>** chart){
-	for (unsigned int i = 0; i < w.size(); i++){
-		for (unsigned int j = 0; j < PL.size(); j++){
-			if (w[i] == PL[j].s)
-				chart[i][i + 1].push_back(PL[j].c);
+// Offset in sets of a new empty bitset
+unsigned int CBFGOracle::newSet(){
+	unsigned int offset = sets.size();
+	sets.resize(offset + W, 0);
+	return offset;
+}
+
+// Offset in sets of the bitset of feature set id, made the first time it is asked for
+unsigned int CBFGOracle::setOf(unsigned int id){
+	auto found = offsets.find(id);
+	if (found != offsets.end())
+		return found->second;
+	unsigned int offset = newSet();
+	for (auto &c : featureSets.contexts(id))
+		setBit(&sets[offset], ids[make_pair(c.lhs, c.rhs)]);
+	offsets.emplace(id, offset);
+	return offset;
+}
+
+// Is every feature of the set at offset set in cell?
+// Like subset() on context vectors, an empty set is never contained
+bool CBFGOracle::contains(const word* cell, unsigned int set) const {
+	bool any = false;
+	for (unsigned int k = 0; k < W; k++){
+		word s = sets[set + k];
+		if (s & ~cell[k])
+			return false;
+		any |= s != 0;
+	}
+	return any;
+}
+
+void CBFGOracle::compile(const vector<PLCRule> &PL, const vector<PCRule> &P){
+	ids.clear();
+	sets.clear();
+	offsets.clear();
+	lexicon.clear();
+	rules.clear();
+
+	// Number the contexts in the order the rules first use them
+	auto number = [&](unsigned int id){
+		for (auto &c : featureSets.contexts(id))
+			ids.emplace(make_pair(c.lhs, c.rhs), ids.size());
+	};
+	for (unsigned int i = 0; i < PL.size(); i++)
+		number(PL[i].c);
+	for (unsigned int i = 0; i < P.size(); i++){
+		number(P[i].lhs);
+		number(P[i].rhs1);
+		number(P[i].rhs2);
+	}
+	W = bitWords(ids.size());
+	auto found = ids.find(make_pair(vector<symbol>(), vector<symbol>()));
+	empty = found == ids.end() ? -1 : (int)found->second;
+
+	for (unsigned int i = 0; i < PL.size(); i++){
+		auto added = lexicon.emplace(PL[i].s, 0);
+		if (added.second)
+			added.first->second = newSet();
+		unsigned int c = setOf(PL[i].c);
+		orBits(&sets[added.first->second], &sets[c], W);
+	}
+
+	unordered_map<uint64_t, unsigned int> merged;	// (rhs1, rhs2) -> rule
+	for (unsigned int i = 0; i < P.size(); i++){
+		if (featureSets.contexts(P[i].rhs1).empty()
+			|| featureSets.contexts(P[i].rhs2).empty())	// never fires, see contains()
+			continue;
+		auto added = merged.emplace(((uint64_t)P[i].rhs1 << 32) | P[i].rhs2, rules.size());
+		if (added.second){
+			Rule r;
+			r.lhs = newSet();
+			r.rhs1 = setOf(P[i].rhs1);
+			r.rhs2 = setOf(P[i].rhs2);
+			rules.push_back(r);
 		}
+		unsigned int lhs = setOf(P[i].lhs);
+		orBits(&sets[rules[added.first->second].lhs], &sets[lhs], W);
+	}
+}
+
+void CBFGOracle::initializeChart(const vector<symbol> &w){
+	for (unsigned int i = 0; i < w.size(); i++){
+		auto found = lexicon.find(w[i]);
+		if (found != lexicon.end())
+			orBits(chart.cell(i, i + 1), &sets[found->second], W);
 	}
 }
 
-void CBFGOracle::closeChart(vector<PCRule> P, vector<vector<context>>** chart, unsigned int n){
-	for (unsigned int width = 1; width <= n; width++){
+void CBFGOracle::closeChart(unsigned int n){
+	for (unsigned int width = 2; width <= n; width++){
 		for (unsigned int start = 0; start <= n - width; start++){
 			unsigned int end = start + width;
+			word* cell = chart.cell(start, end);
 			for (unsigned int mid = start + 1; mid < end; mid++){
-				for (unsigned int i = 0; i < P.size(); i++){
-					if (subset(P[i].rhs1, chart[start][mid])
-						&& subset(P[i].rhs2, chart[mid][end])
-						&& !subset(P[i].lhs, chart[start][end])) // Stops redundacies
-						chart[start][end].push_back(P[i].lhs);
+				const word* left = chart.cell(start, mid);
+				const word* right = chart.cell(mid, end);
+				for (unsigned int i = 0; i < rules.size(); i++){
+					if (contains(left, rules[i].rhs1) && contains(right, rules[i].rhs2))
+						orBits(cell, &sets[rules[i].lhs], W);
 				}
 			}
 		}
 	}
 }
 
-bool CBFGOracle::accepts(vector<string> w, const vector<PLCRule> PL, const vector<PCRule> P){
+bool CBFGOracle::accepts(const vector<symbol> &w){
 	unsigned int n = w.size();
-	vector<vector<context>>** chart = new vector<vector<context>>*[n + 1];	// Chart is dynamically allocated 2D array
-	for (unsigned int i = 0; i <= n; ++i)
-		chart[i] = new vector<vector<context>>[n + 1];
+	if (n == 0 || empty < 0)	// (λ, λ) can't be in any cell
+		return false;
+	chart.reset(n, W);	// Reuses the cells of earlier queries
 
-	// printChart(chart, n);
-	initializeChart(w, PL, chart);
-	// printChart(chart, n);
-	closeChart(P, chart, n);
-	// printChart(chart, n);
+	initializeChart(w);
+	// printChart(chart, W, n);
+	closeChart(n);
+	// printChart(chart, W, n);
 
 	// Is the top left cell the start symbol?
-	context c;
-	bool success = search(chart[0][n], c) ? true : false;
-
-	for (unsigned int i = 0; i <= n; ++i)	// Delete the dynamically allocated array from memory
-		delete[] chart[i];
-	delete[] chart;
-
-	return success;
-}
\ No newline at end of file
+	return testBit(chart.cell(0, n), empty);
+}
@@ -1,21 +1,51 @@
 #ifndef _CYKCBFG_
 #define _CYKCBFG_
 
+#include <map>
 #include <string>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
+#include "bitset.h"
+#include "chart.h"
 #include "grammars.h"
 
+// CYK for a CBFG over bitset feature sets
+//
+// compile() numbers every context the rules use and turns each distinct feature set
+// into a bitset over those numbers.  A cell only ever answers "is every feature of this
+// set in one of the cell's sets?", so it keeps the union of its sets as one bitset
+// and rule tests are word-wide AND/compare.
 class CBFG;
 class CBFGOracle{
 public:
 	CBFGOracle(CBFG* G);
-	bool accepts(const vector<string> w, const vector<PLCRule> PL, const vector<PCRule> P);
+	void compile(const vector<PLCRule> &PL, const vector<PCRule> &P);
+	bool accepts(const vector<symbol> &w);
+	unsigned int features() const { return ids.size(); }
 private:
+	// A rule lhs -> rhs1 rhs2 with each side at an offset in sets
+	// Rules with the same right hand sides are merged into one with the union of their lhs
+	typedef struct{
+		unsigned int lhs, rhs1, rhs2;
+	} Rule;
+
 	CBFG* parent;
-	void initializeChart(vector<string> w, vector<PLCRule> PL, vector<vector<context>>** chart);
-	void closeChart(vector<PCRule> P, vector<vector<context>>** chart, unsigned int n);
+	map<pair<vector<symbol>, vector<symbol>>, unsigned int> ids;	// context -> feature number
+	unsigned int W;				// words in a feature bitset
+	int empty;				// number of the context (λ, λ), -1 if no rule has it
+	vector<word> sets;			// every feature bitset, W words each
+	unordered_map<unsigned int, unsigned int> offsets;	// feature set id -> its bitset in sets
+	unordered_map<symbol, unsigned int> lexicon;	// terminal -> union of its lexical rules' sets
+	vector<Rule> rules;
+	BitChart chart;				// Kept between queries, only grows
 
+	unsigned int newSet();
+	unsigned int setOf(unsigned int id);
+	bool contains(const word* cell, unsigned int set) const;
+	void initializeChart(const vector<symbol> &w);
+	void closeChart(unsigned int n);
 };
 
-#endif
\ No newline at end of file
+#endif
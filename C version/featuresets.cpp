@@ -0,0 +1,37 @@
+#include <algorithm>
+
+#include "featuresets.h"
+#include "membership.h"
+
+FeatureSetTable featureSets;
+
+// Orders contexts by left side, then right side
+static bool before(const context &a, const context &b){
+	if (a.lhs != b.lhs)
+		return a.lhs < b.lhs;
+	return a.rhs < b.rhs;
+}
+
+// Returns the id of the set c, giving it the next free id if it is new
+unsigned int FeatureSetTable::intern(vector<context> c){
+	sort(c.begin(), c.end(), before);
+	uint64_t h = mix64(c.size());
+	for (auto &x : c)
+		h = mix64(h ^ fingerprint(x.lhs)) ^ fingerprint(x.rhs);
+	auto range = ids.equal_range(h);
+	for (auto it = range.first; it != range.second; ++it)
+		if (equal(sets[it->second], c))
+			return it->second;
+	unsigned int id = sets.size();
+	ids.emplace(h, id);
+	sets.push_back(c);
+	return id;
+}
+
+size_t RuleHash::operator()(const PLCRule &r) const {
+	return mix64(((uint64_t)r.c << 32) | r.s);
+}
+
+size_t RuleHash::operator()(const PCRule &r) const {
+	return mix64(mix64(((uint64_t)r.lhs << 32) | r.rhs1) ^ r.rhs2);
+}
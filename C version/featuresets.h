@@ -0,0 +1,40 @@
+#ifndef _FEATURESETS_
+#define _FEATURESETS_
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "types.h"
+
+using namespace::std;
+
+// Gives every distinct set of contexts a dense id (0, 1, 2, ...) and keeps it once
+// A set is sorted before it is looked up, so the order its contexts come in
+// doesn't matter, and two sets are equal exactly when their ids are.
+class FeatureSetTable{
+public:
+	unsigned int intern(vector<context> c);
+	const vector<context> &contexts(unsigned int id) const { return sets[id]; }
+	unsigned int size() const { return sets.size(); }
+	// Forgets every set, so ids start from 0 again; rules holding old ids must go first
+	void clear(){ ids.clear(); sets.clear(); }
+private:
+	unordered_multimap<uint64_t, unsigned int> ids;	// hash of a sorted set -> its id
+	vector<vector<context>> sets;			// id -> sorted set
+};
+
+// Feature sets of every CBFG rule, shared like terminals
+extern FeatureSetTable featureSets;
+
+// Hash and equality of CBFG rules, for unordered sets of rules
+struct RuleHash{
+	size_t operator()(const PLCRule &r) const;
+	size_t operator()(const PCRule &r) const;
+};
+struct RuleEqual{
+	bool operator()(const PLCRule &a, const PLCRule &b) const { return equal(a, b); }
+	bool operator()(const PCRule &a, const PCRule &b) const { return equal(a, b); }
+};
+
+#endif
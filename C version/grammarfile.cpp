@@ -0,0 +1,174 @@
+#include <cstring>
+#include <fstream>
+
+#include "binaryio.h"
+#include "grammarfile.h"
+
+// The last byte is the format's version
+static const char MAGIC[8] = { 'I', 'I', 'L', 'G', 'R', 'A', 'M', '2' };
+static const uint32_t ENDIAN_MARK = 0x01020304;
+
+///////////////////////////////
+/* Writing                   */
+///////////////////////////////
+
+// Every array is written as it is in memory, aligned so a reader can use it in place
+template <class T>
+static void putSpan(vector<char> &out, const Span<T> &s){
+	putAligned(out, s.data(), s.size());
+}
+
+static void putIndex(vector<char> &out, const GrammarIndex &index){
+	put32(out, index.nonterminals);
+	put32(out, index.ntWords);
+	putSpan(out, index.lexicon);
+	putSpan(out, index.lexicalSets);
+	putSpan(out, index.pairs);
+	putSpan(out, index.firstEntry);
+	putSpan(out, index.entries);
+	putSpan(out, index.parentSets);
+}
+
+bool writeBinaryGrammar(const string &file, const CFG &G){
+	vector<char> out;
+	put(out, MAGIC, sizeof(MAGIC));
+	put32(out, ENDIAN_MARK);
+	put32(out, sizeof(word));
+
+	putNames(out, G.nonterminals);
+	putNames(out, terminals);
+	put32(out, G.start);
+	putArray(out, G.rules.PL);
+	putArray(out, G.rules.P);
+	putStrings(out, G.samples);
+	putIndex(out, buildIndex(G.rules.PL, G.rules.P));
+
+	return replaceFile(file, out);
+}
+
+///////////////////////////////
+/* Reading                   */
+///////////////////////////////
+
+// Is every file symbol's id the same in this run?
+static bool identity(const vector<symbol> &ids){
+	for (symbol a = 0; a < ids.size(); a++)
+		if (ids[a] != a)
+			return false;
+	return true;
+}
+
+// Renumbers file terminal ids to this run's, false if one is out of range
+static bool renumber(symbol &a, const vector<symbol> &ids){
+	if (a >= ids.size())
+		return false;
+	a = ids[a];
+	return true;
+}
+
+template <class T>
+static void getSpan(Cursor &c, Span<T> &s){
+	const T* p;
+	size_t n;
+	c.getAligned(p, n);
+	s = Span<T>(p, n);
+}
+
+// What a mapped index keeps alive: the file, and its lexicon in this run's terminal
+// ids if they are not the file's
+struct MappedIndex{
+	shared_ptr<MappedFile> file;
+	vector<unsigned int> lexicon;
+};
+
+// Points index into the mapped file, checking every offset and id so a damaged file
+// can't send a lookup outside the arrays
+static bool getIndex(Cursor &c, GrammarIndex &index, const vector<symbol> &terminalIds,
+	const shared_ptr<MappedFile> &file){
+	index.nonterminals = c.get32();
+	unsigned int N = index.nonterminals, W = index.ntWords = c.get32();
+	getSpan(c, index.lexicon);
+	getSpan(c, index.lexicalSets);
+	getSpan(c, index.pairs);
+	getSpan(c, index.firstEntry);
+	getSpan(c, index.entries);
+	getSpan(c, index.parentSets);
+	if (!c.ok || W != bitWords(N) || index.lexicon.size() > terminalIds.size())
+		return false;
+
+	for (auto offset : index.lexicon)
+		if (offset != GrammarIndex::NONE && offset + (size_t)W > index.lexicalSets.size())
+			return false;
+	size_t size = index.pairs.size(), used = 0;
+	if ((size & (size - 1)) != 0)
+		return false;
+	for (auto &slot : index.pairs)
+		if (slot.key != EMPTY_PAIR){
+			if (slot.key >> 32 >= N || (slot.key & 0xffffffff) >= N || slot.parents + (size_t)W > index.parentSets.size())
+				return false;
+			used++;
+		}
+	if (used * 2 > size)	// a probe for a missing pair has to reach an empty slot
+		return false;
+	if (index.firstEntry.size() != N + 1 || index.firstEntry[0] != 0 || index.firstEntry[N] != index.entries.size())
+		return false;
+	for (symbol B = 0; B < N; B++)
+		if (index.firstEntry[B] > index.firstEntry[B + 1])
+			return false;
+	for (auto &e : index.entries)
+		if (e.right >= N || e.parents + (size_t)W > index.parentSets.size())
+			return false;
+
+	shared_ptr<MappedIndex> storage = make_shared<MappedIndex>();
+	storage->file = file;
+	if (!identity(terminalIds)){	// move every terminal's offset to its id in this run
+		vector<unsigned int> &lexicon = storage->lexicon;
+		for (symbol a = 0; a < index.lexicon.size(); a++){
+			symbol b = terminalIds[a];
+			if (b >= lexicon.size())
+				lexicon.resize(b + 1, GrammarIndex::NONE);
+			lexicon[b] = index.lexicon[a];
+		}
+		index.lexicon = lexicon;
+	}
+	index.storage = storage;
+	return true;
+}
+
+bool isBinaryGrammar(const string &file){
+	char magic[sizeof(MAGIC)];
+	ifstream input(file.c_str(), ios::binary);
+	return input.read(magic, sizeof(magic)) && memcmp(magic, MAGIC, sizeof(MAGIC) - 1) == 0;
+}
+
+CFG* readBinaryGrammar(const string &file){
+	shared_ptr<MappedFile> map = make_shared<MappedFile>(file);
+	Cursor c(*map);
+	char magic[sizeof(MAGIC)];
+	c.take(magic, sizeof(magic));
+	if (!c.ok || memcmp(magic, MAGIC, sizeof(MAGIC)) != 0 || c.get32() != ENDIAN_MARK || c.get32() != sizeof(word))
+		return NULL;
+
+	SymbolTable nonterminals;
+	vector<symbol> nonterminalIds, terminalIds;
+	c.getNames(nonterminals, nonterminalIds);	// a fresh table, so these are 0, 1, 2, ...
+	c.getNames(terminals, terminalIds);
+	symbol start = c.get32();
+	CFGRules rules;
+	c.getArray(rules.PL);
+	c.getArray(rules.P);
+	vector<vector<symbol>> samples;
+	c.getStrings(samples, terminalIds);
+	GrammarIndex index;
+	unsigned int N = nonterminals.size();
+	if (!c.ok || !getIndex(c, index, terminalIds, map) || index.nonterminals > N || (start >= N && N > 0))
+		return NULL;
+
+	for (auto &r : rules.PL)
+		if (r.left >= N || !renumber(r.right, terminalIds))
+			return NULL;
+	for (auto &r : rules.P)
+		if (r.left >= N || r.one >= N || r.two >= N)
+			return NULL;
+	return new CFG(start, rules, samples, nonterminals, index);
+}
@@ -0,0 +1,33 @@
+#ifndef _GRAMMARFILE_
+#define _GRAMMARFILE_
+
+#include <string>
+
+#include "grammars.h"
+
+using namespace::std;
+
+// A target grammar in binary, written once from a text grammar so later runs load it
+// without parsing
+//
+// The file is a header (magic ending in the format's version, byte order mark, word
+// size) followed by the nonterminal and terminal names, the start symbol, the rules,
+// the samples and the oracle's GrammarIndex.  Each of them is a count followed by an
+// array of fixed size integers in native byte order.  readBinaryGrammar maps the file
+// read-only and shared, and copies the names, rules and samples out of it.  The index's
+// arrays are used where they are: each starts on an 8 byte boundary, the pair map is
+// the open addressing table lookups probe, and the index keeps the mapping alive for as
+// long as it or a copy of it lives, so every process loading the file shares one copy
+// of them.  Terminals are interned in file order, so they keep the file's ids if the
+// table starts out empty; otherwise the rules and samples are renumbered, and the index
+// gets a lexicon of its own.
+
+// Does file start with the binary grammar magic, of any version?
+bool isBinaryGrammar(const string &file);
+// Writes G and every terminal interned so far to file, returns false if it can't
+// The file is replaced with a rename, so runs mapping the old one are not disturbed
+bool writeBinaryGrammar(const string &file, const CFG &G);
+// Loads a file written by writeBinaryGrammar, or returns NULL if it can't be read
+CFG* readBinaryGrammar(const string &file);
+
+#endif
@@ -1,29 +1,42 @@
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+
+#include "featuresets.h"
+#include "grammarfile.h"
 #include "grammars.h"
 
 //////////////////////////////
 /* CFG Class emplimentation */
 //////////////////////////////
 
-CFG::CFG(string s, CFGRules r, vector<vector<string>> sam)
-	:start(s), rules(r), samples(sam), queries(0), oracle(new CFGOracle()) {}
+CFG::CFG(symbol s, CFGRules r, vector<vector<symbol>> sam, SymbolTable nt)
+	:start(s), rules(r), samples(sam), nonterminals(nt), queries(0), oracle(new CFGOracle()) {
+	oracle->compile(rules.PL, rules.P);
+}
+
+CFG::CFG(symbol s, CFGRules r, vector<vector<symbol>> sam, SymbolTable nt, GrammarIndex index)
+	:start(s), rules(r), samples(sam), nonterminals(nt), queries(0), oracle(new CFGOracle()) {
+	oracle->compile(move(index));
+}
 
 // Prints the target CFG grammar in a readable format
 void CFG::print(){
 	cout << "Target Grammar:" << endl;
-	cout << "  Start symbol: " << start << endl;
+	cout << "  Start symbol: " << nonterminals.name(start) << endl;
 	cout << "  Lexical Rules:" << endl;
 	for (unsigned int i = 0; i < rules.PL.size(); i++)
-		cout << "    " << rules.PL[i].left << " -> " << rules.PL[i].right << endl;
+		cout << "    " << nonterminals.name(rules.PL[i].left) << " -> " << terminals.name(rules.PL[i].right) << endl;
 	cout << "  Nonlexical Rules:" << endl;
 	for (unsigned int i = 0; i < rules.P.size(); i++){
-		cout << "    " << rules.P[i].left << " ->";
-		cout << " " << rules.P[i].one << "," << rules.P[i].two << endl;
+		cout << "    " << nonterminals.name(rules.P[i].left) << " ->";
+		cout << " " << nonterminals.name(rules.P[i].one) << "," << nonterminals.name(rules.P[i].two) << endl;
 	}
 	cout << "  Samples:" << endl;
 	for (unsigned int i = 0; i < samples.size(); i++){
 		cout << "    ";
 		for (unsigned int j = 0; j < samples[i].size(); j++)
-			cout << samples[i][j] << " ";
+			cout << terminals.name(samples[i][j]) << " ";
 		cout << endl;
 	}
 	cout << endl;
@@ -37,22 +50,214 @@ void CFG::checkSamples(){
 		if (accepted){
 			cout << "Accepted by target grammar:";
 			for (unsigned int j = 0; j < samples[i].size(); j++)
-				cout << " " << samples[i][j];
+				cout << " " << terminals.name(samples[i][j]);
 			cout << endl;
 		}
 		else{
 			cout << "Rejected by target grammar:";
 			for (unsigned int j = 0; j < samples[i].size(); j++)
-				cout << " " << samples[i][j];
+				cout << " " << terminals.name(samples[i][j]);
 			cout << endl;
 			exit(1);
 		}
 	}
 }
 
-bool CFG::accepts(vector<string> w){
-	queries++;
-	return oracle->accepts(w, rules.PL, rules.P, start);
+// Answers from the oracle's history when w has been asked before
+// queries counts the strings the oracle actually had to parse
+bool CFG::accepts(const vector<symbol> &w){
+	signed char &answer = oracle->history.lookup(w);
+	if (answer < 0){
+		queries++;
+		answer = oracle->accepts(w, rules.PL, rules.P, start);
+		oracle->store.add(w, answer == 1);
+	}
+	return answer == 1;
+}
+
+vector<word> CFG::acceptsBatch(const vector<vector<symbol>> &ws){
+	vector<word> result(bitWords(ws.size()), 0);
+	vector<size_t> jobs;		// first occurrence of each string the history doesn't know
+	vector<size_t> repeats;		// later occurrences of those strings
+	for (size_t i = 0; i < ws.size(); i++){
+		signed char &answer = oracle->history.lookup(ws[i]);
+		if (answer == 1)
+			setBit(result.data(), i);
+		else if (answer == -1){
+			answer = -2;	// queued, so a repeat of ws[i] is told apart from a new string
+			jobs.push_back(i);
+		}
+		else if (answer == -2)
+			repeats.push_back(i);
+	}
+	if (jobs.empty())
+		return result;
+
+	vector<const vector<symbol>*> batch;
+	for (size_t i : jobs)
+		batch.push_back(&ws[i]);
+	vector<word> answers = oracle->acceptsBatch(batch, rules.PL, rules.P, start);
+	queries += jobs.size();
+	for (size_t j = 0; j < jobs.size(); j++){
+		bool answer = testBit(answers.data(), j);
+		oracle->history.add(ws[jobs[j]], answer);
+		oracle->store.add(ws[jobs[j]], answer);
+		if (answer)
+			setBit(result.data(), jobs[j]);
+	}
+	for (size_t i : repeats){
+		int answer = oracle->history.find(ws[i]);
+		if (answer < 0)		// the history was emptied to stay under its limit
+			answer = accepts(ws[i]);
+		if (answer == 1)
+			setBit(result.data(), i);
+	}
+	return result;
+}
+
+uint64_t CFG::hash() const {
+	vector<string> lines;
+	lines.push_back("start " + nonterminals.name(start));
+	for (auto &r : rules.PL)
+		lines.push_back("lexical " + nonterminals.name(r.left) + "," + terminals.name(r.right));
+	for (auto &r : rules.P)
+		lines.push_back("nonlexical " + nonterminals.name(r.left) + "," + nonterminals.name(r.one)
+			+ "," + nonterminals.name(r.two));
+	return grammarHash(lines);
+}
+
+// Cuts the weight off a rule line with more than commas commas whose last field is a
+// number, and returns it, or 1 if the line has none
+static double splitWeight(string &line, unsigned int commas){
+	if ((unsigned int)count(line.begin(), line.end(), ',') <= commas)
+		return 1;
+	size_t last = line.rfind(',');
+	const char* field = line.c_str() + last + 1;
+	char* end;
+	double weight = strtod(field, &end);
+	if (end == field || *end != '\0' || !(weight >= 0))
+		return 1;
+	line.erase(last);
+	return weight;
+}
+
+// Takes the input file and creates an CFG object for the target grammar
+CFG* extract(char* file, RuleWeights* weights){
+	if (file == NULL){
+		cout << "No input file given!" << endl;
+		exit(1);
+	}
+	if (isBinaryGrammar(file)){
+		CFG* G = readBinaryGrammar(file);
+		if (G == NULL){
+			cout << "Unable to read binary grammar " << file << endl;
+			exit(1);
+		}
+		if (weights){
+			weights->PL.assign(G->rules.PL.size(), 1);
+			weights->P.assign(G->rules.P.size(), 1);
+		}
+		return G;
+	}
+
+	ifstream input(file);
+	string line;
+
+	symbol start = 0;
+	CFGRules rules;
+	vector<vector<symbol>> samples;
+	SymbolTable nonterminals;
+
+	if (input.is_open())
+	{
+		enum test_data_types{ starter, lexical, nonlexical, sample} type;
+		type = starter;
+
+		while (getline(input, line)){
+			if (line == "start:"){
+				type = starter;
+				continue;
+			}
+			else if (line == "lexical:"){
+				type = lexical;
+				continue;
+			}
+			else if (line == "nonlexical:"){
+				type = nonlexical;
+				continue;
+			}
+			else if (line == "samples:"){
+				type = sample;
+				continue;
+			}
+
+			PLRule PL;
+			PRule P;
+			string temp = "";
+			int num = 0;
+			double weight;
+
+			switch (type){
+			case starter:
+				start = nonterminals.intern(line);
+				break;
+			case lexical:
+				weight = splitWeight(line, 1);
+				if (weights)
+					weights->PL.push_back(weight);
+				unsigned int i;
+				for (i = 0; i < line.length() && line[i] != ','; i++);
+				PL.left = nonterminals.intern(line.substr(0, i));
+				PL.right = terminals.intern(line.substr(i+1, line.length() - i - 1));
+				rules.PL.push_back(PL);
+				break;
+			case nonlexical:
+				weight = splitWeight(line, 2);
+				if (weights)
+					weights->P.push_back(weight);
+				for (unsigned int i = 0; i < line.length(); i++){
+					if (line[i] != ',')
+						temp += line[i];
+					else{
+						switch (num){
+						case 0:
+							P.left = nonterminals.intern(temp);
+							break;
+						case 1:
+							P.one = nonterminals.intern(temp);
+							break;
+						}
+						num++;
+						temp = "";
+					}
+				}
+				P.two = nonterminals.intern(temp);
+				rules.P.push_back(P);
+				break;
+			case sample:
+				vector<symbol> tempsample;
+				for (unsigned int i = 0; i < line.length(); i++){
+					if (line[i] != ' ')
+						temp += line[i];
+					else{
+						tempsample.push_back(terminals.intern(temp));
+						temp = "";
+					}
+				}
+				tempsample.push_back(terminals.intern(temp));
+				samples.push_back(tempsample);
+			}
+		}
+
+		input.close();
+
+		CFG* G = new CFG(start, rules, samples, nonterminals);
+		return G;
+	}
+	else {
+		cout << "Unable to open file" << endl;
+		return NULL;
+	}
 }
 
 ///////////////////////////////
@@ -60,88 +265,94 @@ bool CFG::accepts(vector<string> w){
 ///////////////////////////////
 
 CBFG::CBFG(CBFGRules r)
-	:rules(r), oracle(new CBFGOracle(this)) {}
+	:rules(r), oracle(new CBFGOracle(this)) {
+	oracle->compile(rules.PL, rules.P);
+}
 
 // Auxiliary function to make function calls in main look nicer
-bool CBFG::accepts(vector<string> w){
-	return oracle->accepts(w, rules.PL, rules.P);
+bool CBFG::accepts(vector<symbol> w){
+	return oracle->accepts(w);
 }
 
 // Print out a PLC rule in a readable format
 void printPLCRule(PLCRule PL){
-	for (unsigned int i = 0; i < PL.c.size(); i++){
+	const vector<context> &c = featureSets.contexts(PL.c);
+	for (unsigned int i = 0; i < c.size(); i++){
 		cout << "(";
-		for (unsigned int j = 0; j < PL.c[i].lhs.size(); j++){
-			cout << PL.c[i].lhs[j];
-			if (j < PL.c[i].lhs.size() - 1)
+		for (unsigned int j = 0; j < c[i].lhs.size(); j++){
+			cout << terminals.name(c[i].lhs[j]);
+			if (j < c[i].lhs.size() - 1)
 				cout << " ";
 		}
 		cout << ",";
-		for (unsigned int j = 0; j < PL.c[i].rhs.size(); j++){
-			cout << PL.c[i].rhs[j];
-			if (j < PL.c[i].rhs.size() - 1)
+		for (unsigned int j = 0; j < c[i].rhs.size(); j++){
+			cout << terminals.name(c[i].rhs[j]);
+			if (j < c[i].rhs.size() - 1)
 				cout << " ";
 		}
 		cout << ")";
-		if (i < PL.c.size() - 1)
+		if (i < c.size() - 1)
 			cout << ",";
 	}
-	cout << "  ->  " << PL.s << endl;
+	cout << "  ->  " << terminals.name(PL.s) << endl;
 }
 
 // Print out a PC rule in a readable format
 void printPCRule(PCRule P){
-	for (unsigned int i = 0; i < P.lhs.size(); i++){
+	const vector<context> &lhs = featureSets.contexts(P.lhs);
+	const vector<context> &rhs1 = featureSets.contexts(P.rhs1);
+	const vector<context> &rhs2 = featureSets.contexts(P.rhs2);
+	for (unsigned int i = 0; i < lhs.size(); i++){
 		cout << "(";
-		for (unsigned int j = 0; j < P.lhs[i].lhs.size(); j++){
-			cout << P.lhs[i].lhs[j];
-			if (j < P.lhs[i].lhs.size() - 1)
+		for (unsigned int j = 0; j < lhs[i].lhs.size(); j++){
+			cout << terminals.name(lhs[i].lhs[j]);
+			if (j < lhs[i].lhs.size() - 1)
 				cout << " ";
 		}
 		cout << ",";
-		for (unsigned int j = 0; j < P.lhs[i].rhs.size(); j++){
-			cout << P.lhs[i].rhs[j];
-			if (j < P.lhs[i].rhs.size() - 1)
+		for (unsigned int j = 0; j < lhs[i].rhs.size(); j++){
+			cout << terminals.name(lhs[i].rhs[j]);
+			if (j < lhs[i].rhs.size() - 1)
 				cout << " ";
 		}
 		cout << ")";
-		if (i < P.lhs.size() - 1)
+		if (i < lhs.size() - 1)
 			cout << ",";
 	}
 	cout << "  ->  ";
-	for (unsigned int i = 0; i < P.rhs1.size(); i++){
+	for (unsigned int i = 0; i < rhs1.size(); i++){
 		cout << "(";
-		for (unsigned int j = 0; j < P.rhs1[i].lhs.size(); j++){
-			cout << P.rhs1[i].lhs[j];
-			if (j < P.rhs1[i].lhs.size() - 1)
+		for (unsigned int j = 0; j < rhs1[i].lhs.size(); j++){
+			cout << terminals.name(rhs1[i].lhs[j]);
+			if (j < rhs1[i].lhs.size() - 1)
 				cout << " ";
 		}
 		cout << ",";
-		for (unsigned int j = 0; j < P.rhs1[i].rhs.size(); j++){
-			cout << P.rhs1[i].rhs[j];
-			if (j < P.rhs1[i].rhs.size() - 1)
+		for (unsigned int j = 0; j < rhs1[i].rhs.size(); j++){
+			cout << terminals.name(rhs1[i].rhs[j]);
+			if (j < rhs1[i].rhs.size() - 1)
 				cout << " ";
 		}
 		cout << ")";
-		if (i < P.rhs1.size() - 1)
+		if (i < rhs1.size() - 1)
 			cout << ",";
 	}
 	cout << "     ";
-	for (unsigned int i = 0; i < P.rhs2.size(); i++){
+	for (unsigned int i = 0; i < rhs2.size(); i++){
 		cout << "(";
-		for (unsigned int j = 0; j < P.rhs2[i].lhs.size(); j++){
-			cout << P.rhs2[i].lhs[j];
-			if (j < P.rhs2[i].lhs.size() - 1)
+		for (unsigned int j = 0; j < rhs2[i].lhs.size(); j++){
+			cout << terminals.name(rhs2[i].lhs[j]);
+			if (j < rhs2[i].lhs.size() - 1)
 				cout << " ";
 		}
 		cout << ",";
-		for (unsigned int j = 0; j < P.rhs2[i].rhs.size(); j++){
-			cout << P.rhs2[i].rhs[j];
-			if (j < P.rhs2[i].rhs.size() - 1)
+		for (unsigned int j = 0; j < rhs2[i].rhs.size(); j++){
+			cout << terminals.name(rhs2[i].rhs[j]);
+			if (j < rhs2[i].rhs.size() - 1)
 				cout << " ";
 		}
 		cout << ")";
-		if (i < P.rhs2.size() - 1)
+		if (i < rhs2.size() - 1)
 			cout << ",";
 	}
 	cout << endl;
@@ -164,19 +375,19 @@ void CBFG::print(){
 }
 
 // Check all of the input samples to make sure they are accepted by grammar
-void CBFG::checkSamples(vector<vector<string>> s){
+void CBFG::checkSamples(vector<vector<symbol>> s){
 	for (unsigned int i = 0; i < s.size(); i++){
 		bool accepted = accepts(s[i]);
 		if (accepted){
 			cout << "Accepted by leaner's grammar:";
 			for (unsigned int j = 0; j < s[i].size(); j++)
-				cout << " " << s[i][j];
+				cout << " " << terminals.name(s[i][j]);
 			cout << endl;
 		}
 		else{
 			cout << "Rejected by learner's grammar:";
 			for (unsigned int j = 0; j < s[i].size(); j++)
-				cout << " " << s[i][j];
+				cout << " " << terminals.name(s[i][j]);
 			cout << endl;
 		}
 	}
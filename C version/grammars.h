@@ -14,25 +14,38 @@ class CFGOracle;
 
 class CFG{
 public:
-	CFG(string s, CFGRules r, vector<vector<string>> sam);
+	CFG(symbol s, CFGRules r, vector<vector<symbol>> sam, SymbolTable nt);
+	// Same, with the oracle's index already built from r (see grammarfile.h)
+	CFG(symbol s, CFGRules r, vector<vector<symbol>> sam, SymbolTable nt, GrammarIndex index);
 	void print();
 	void checkSamples();
-	bool accepts(vector<string> w);
-	const string start;
+	bool accepts(const vector<symbol> &w);
+	// Answers every string of ws at once (bit i of the result for ws[i])
+	// Strings in the history or repeated in ws are only parsed once, the rest in parallel
+	vector<word> acceptsBatch(const vector<vector<symbol>> &ws);
+	uint64_t hash() const;	// same for every file with these rules, whatever the samples
+	const symbol start;
 	const CFGRules rules;
-	const vector<vector<string>> samples;
+	const vector<vector<symbol>> samples;
+	const SymbolTable nonterminals;
 	int queries;
 	CFGOracle* oracle;
 };
 
+// Takes the input file and creates an CFG object for the target grammar
+// The file may be text or a binary grammar written by writeBinaryGrammar
+// A rule may end with one more field, its weight (A,a,0.25 or A,B,C,0.5), which only
+// goes into weights.  A rule without one weighs 1, as does every rule of a binary grammar.
+CFG* extract(char* file, RuleWeights* weights = NULL);
+
 class CBFGOracle;
 
 class CBFG{
 public:
 	CBFG(CBFGRules r);
 	void print();
-	void checkSamples(vector<vector<string>> s);
-	bool accepts(vector<string> w);
+	void checkSamples(vector<vector<symbol>> s);
+	bool accepts(vector<symbol> w);
 	CBFGRules rules;
 	CBFGOracle* oracle;
 };
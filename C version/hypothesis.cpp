@@ -0,0 +1,85 @@
+#include "hypothesis.h"
+
+const unsigned int Hypothesis::NONE;
+
+Hypothesis::Hypothesis(ObservationTable &t)
+	: table(t), strings(0), version(t.version()) {}
+
+// The id of the features of a filled row
+unsigned int Hypothesis::featureSet(unsigned int row){
+	if (rowSets.size() <= row)
+		rowSets.resize(row + 1, NONE);
+	if (rowSets[row] == NONE)
+		rowSets[row] = featureSets.intern(table.features(row));
+	return rowSets[row];
+}
+
+// Makes a rule of every instance from the given ones on that has no equal rule yet
+void Hypothesis::sort(size_t firstLexical, size_t firstBinary){
+	for (size_t i = firstLexical; i < lexical.size(); i++){
+		PLCRule rule;
+		rule.c = featureSet(lexical[i].w);
+		rule.s = lexical[i].a;
+		if (lexicalRules.insert(rule).second)
+			current.PL.push_back(rule);
+	}
+	for (size_t i = firstBinary; i < binary.size(); i++){
+		PCRule rule;
+		rule.lhs = featureSet(binary[i].w);
+		rule.rhs1 = featureSet(binary[i].a);
+		rule.rhs2 = featureSet(binary[i].b);
+		if (binaryRules.insert(rule).second)
+			current.P.push_back(rule);
+	}
+}
+
+bool Hypothesis::update(const vector<vector<symbol>> &K){
+	size_t oldLexical = lexical.size();
+	size_t oldBinary = binary.size();
+	for (; strings < K.size(); strings++){
+		const vector<symbol> &w = K[strings];
+		Instance rule;
+		rule.w = table.rowOf(w);
+		if (w.size() == 1){	// Lexical rule
+			rule.a = w[0];
+			rule.b = 0;
+			lexical.push_back(rule);
+		}
+		else {	// Nonlexical rule
+			for (unsigned int j = 1; j < w.size(); j++){
+				rule.a = table.rowOf(vector<symbol>(w.begin(), w.begin() + j));
+				rule.b = table.rowOf(vector<symbol>(w.begin() + j, w.end()));
+				binary.push_back(rule);
+			}
+		}
+	}
+
+	// New features change every rule, so all of them are sorted again
+	bool all = version != table.version();
+	size_t firstLexical = all ? 0 : oldLexical;
+	size_t firstBinary = all ? 0 : oldBinary;
+	if (firstLexical == lexical.size() && firstBinary == binary.size())
+		return false;
+
+	vector<unsigned int> rows;
+	for (size_t i = firstLexical; i < lexical.size(); i++)
+		rows.push_back(lexical[i].w);
+	for (size_t i = firstBinary; i < binary.size(); i++){
+		rows.push_back(binary[i].w);
+		rows.push_back(binary[i].a);
+		rows.push_back(binary[i].b);
+	}
+	table.fill(rows);
+
+	size_t rules = current.PL.size() + current.P.size();
+	if (all){
+		version = table.version();
+		rowSets.clear();
+		lexicalRules.clear();
+		binaryRules.clear();
+		current.PL.clear();
+		current.P.clear();
+	}
+	sort(firstLexical, firstBinary);
+	return all || current.PL.size() + current.P.size() != rules;
+}
@@ -0,0 +1,50 @@
+#ifndef _HYPOTHESIS_
+#define _HYPOTHESIS_
+
+#include <unordered_set>
+#include <vector>
+
+#include "featuresets.h"
+#include "observation.h"
+#include "types.h"
+
+using namespace::std;
+
+// The rules of g(K, F), kept up to date as the learner grows K and F
+//
+// g makes one rule per string of K (lexical) or per split of it (binary) and drops
+// the rules it has already made.  Here every such rule is kept with the table rows
+// of its strings.  A row's features are interned in featureSets once, so a rule is
+// a few ids and a new rule is checked with one hash set lookup instead of a scan of
+// all rules.  update() only works on the strings K gained since the last call, unless
+// F changed, which changes every rule's features and makes it sort them all again.
+class Hypothesis{
+public:
+	Hypothesis(ObservationTable &table);
+	// Brings the rules up to date with K and the table's features, and returns
+	// whether they changed.  K may only have grown at the end since the last call.
+	bool update(const vector<vector<symbol>> &K);
+	// The same rules, in the same order, as g(K, F)
+	const CBFGRules &rules() const { return current; }
+private:
+	// The rows of w and of its halves wa wb, or of w and its terminal for a lexical rule
+	typedef struct{
+		unsigned int w, a, b;
+	} Instance;
+
+	ObservationTable &table;
+	unsigned int strings;		// strings of K already made into rules
+	unsigned int version;		// table.version() the rules were sorted under
+	vector<Instance> lexical;
+	vector<Instance> binary;
+	vector<unsigned int> rowSets;	// row -> id of its features, NONE until asked for
+	unordered_set<PLCRule, RuleHash, RuleEqual> lexicalRules;
+	unordered_set<PCRule, RuleHash, RuleEqual> binaryRules;
+	CBFGRules current;
+	static const unsigned int NONE = ~0u;
+
+	unsigned int featureSet(unsigned int row);
+	void sort(size_t firstLexical, size_t firstBinary);
+};
+
+#endif
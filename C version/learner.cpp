@@ -0,0 +1,120 @@
+#include "learner.h"
+
+// Just like python version
+void addNEsubstrings(vector<vector<symbol>> &sofar, vector<symbol> w){
+	for (unsigned int i = 0; i < w.size(); i++){
+		for (unsigned int j = i; j <= w.size(); j++){
+			vector<symbol> temp;
+			for (unsigned int k = i; k < j; k++) // Python: s=w[i:j]
+				temp.push_back(w[k]);
+
+			if (!search(sofar, temp)) // If temp is not already in sofar, add it
+				sofar.push_back(temp);
+		}
+	}
+}
+
+// Just like python vesion
+void addContexts(vector<context> &sofar, vector<symbol> w){
+	for (unsigned int i = 0; i < w.size(); i++){
+		for (unsigned int j = i + 1; j < w.size() + 1; j++){
+			context c;
+			for (unsigned int k = 0; k < i; k++)
+				c.lhs.push_back(w[k]);
+			for (unsigned int k = j; k < w.size(); k++)
+				c.rhs.push_back(w[k]);
+
+			if (!search(sofar, c))	// If c is not already in sofar, add it
+				sofar.push_back(c);
+		}
+	}
+}
+
+// Just like python version
+bool notDinLG(vector<vector<symbol>> D, CBFG G){
+	for (unsigned int i = 0; i < D.size(); i++)
+		if (!G.accepts(D[i]))
+			return true;
+	return false;
+}
+
+// Just like python version
+// Whether FL(F, K[i]) is a subset of FL(F, SubD[i]) is read straight off the table rows
+bool reallyLongCond(vector<vector<symbol>> SubD, vector<vector<symbol>> K,
+	vector<context> ConD, ObservationTable &table, CFG* G){
+	for (unsigned int i = 0; i < SubD.size(); i++){
+		for (unsigned int j = 0; j < K.size(); j++){
+			if (table.included(K[i], SubD[i]))
+				for (unsigned int k = 0; k < ConD.size(); k++){
+				// The following 10 lines are the same as the 2 lines in python (stupid c++)
+				// We just Odot (insert) the given string from K with the context from ConD
+					vector<symbol> lur;
+					// Add left side of the context
+					for (unsigned int l = 0; l < ConD[k].lhs.size(); l++)
+						lur.push_back(ConD[k].lhs[l]);
+					// Add string
+					for (unsigned int l = 0; l < K[j].size(); l++)
+						lur.push_back(K[j][l]);
+					// Add right side of context
+					for (unsigned int l = 0; l < ConD[k].rhs.size(); l++)
+						lur.push_back(ConD[k].rhs[l]);
+					// Test if lur is in language
+
+					if (G->accepts(lur))
+						return true;
+				}
+		}
+	}
+	return false;
+}
+
+Learner::Learner(CFG* t)
+	: target(t), table(t), rules(table), Ghat(CBFGRules()) {
+	rules.update(K);
+	Ghat = CBFG(rules.rules());
+}
+
+void Learner::learn(const vector<symbol> &w){
+	D.push_back(w);
+	// printD(D);
+	addContexts(ConD, w);
+	// printContextVector(ConD);
+	addNEsubstrings(SubD, w);
+	// printSubstringVector(SubD);
+	if (notDinLG(D, Ghat)){
+		K = SubD;
+		F = ConD;
+		table.setFeatures(F);
+	}
+	else if (reallyLongCond(SubD, K, ConD, table, target)){
+		F = ConD;
+		table.setFeatures(F);
+	}
+
+	if (rules.update(K))
+		Ghat = CBFG(rules.rules());
+	// Ghat.print();
+}
+
+Checkpoint Learner::state() const{
+	Checkpoint c;
+	c.D = D;
+	c.K = K;
+	c.SubD = SubD;
+	c.F = F;
+	c.ConD = ConD;
+	return c;
+}
+
+// The table, rules and hypothesis only depend on K and F, so they are made again
+// from them, with every cell answered from the oracle's history
+void Learner::restore(const Checkpoint &c){
+	D = c.D;
+	K = c.K;
+	SubD = c.SubD;
+	F = c.F;
+	ConD = c.ConD;
+	table.setFeatures(F);
+	rules.update(K);
+	Ghat = CBFG(rules.rules());
+}
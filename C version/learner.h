@@ -0,0 +1,43 @@
+#ifndef _LEARNER_
+#define _LEARNER_
+
+#include <vector>
+
+#include "checkpoint.h"
+#include "grammars.h"
+#include "hypothesis.h"
+#include "observation.h"
+#include "types.h"
+
+using namespace::std;
+
+// Adds every non-empty substring of w to sofar that isn't in it yet
+void addNEsubstrings(vector<vector<symbol>> &sofar, vector<symbol> w);
+// Adds every context (l, r) of w with l u r = w for a non-empty u to sofar that isn't in it yet
+void addContexts(vector<context> &sofar, vector<symbol> w);
+
+// The state of IIL between samples, so samples can be given one at a time and the
+// hypothesis looked at in between
+class Learner{
+public:
+	Learner(CFG* target);
+	// One step of IIL with the next sample w
+	void learn(const vector<symbol> &w);
+	CBFG &hypothesis() { return Ghat; }
+	const vector<vector<symbol>> &samples() const { return D; }
+	// The learner's sets, for a checkpoint, and back
+	Checkpoint state() const;
+	void restore(const Checkpoint &c);
+private:
+	CFG* target;
+	vector<vector<symbol>> K;
+	vector<vector<symbol>> D;
+	vector<context> F;
+	vector<context> ConD;
+	vector<vector<symbol>> SubD;
+	ObservationTable table;	// kept for the whole run, FL(F, w) is a row of it
+	Hypothesis rules;	// the rules of g(K, F), updated as K and F grow
+	CBFG Ghat;
+};
+
+#endif
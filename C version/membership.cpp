@@ -0,0 +1,168 @@
+#include <algorithm>
+#include <cstring>
+
+#include "membership.h"
+
+uint64_t mix64(uint64_t x){
+	x ^= x >> 33;
+	x *= 0xff51afd7ed558ccdULL;
+	x ^= x >> 33;
+	x *= 0xc4ceb9fe1a85ec53ULL;
+	x ^= x >> 33;
+	return x;
+}
+
+uint64_t fingerprint(const vector<symbol> &w){
+	uint64_t h = mix64(w.size() + 0x9e3779b97f4a7c15ULL);
+	for (symbol s : w)
+		h = mix64(h ^ (s + 0x9e3779b97f4a7c15ULL));
+	return h;
+}
+
+MembershipCache::MembershipCache(size_t m)
+	: used(0), maxBytes(m), generation(0), hitCount(0), missCount(0) {
+	Entry empty = { 0, 0, EMPTY, -1, false, 0 };
+	table.assign(1024, empty);
+}
+
+void MembershipCache::clear(){
+	Entry empty = { 0, 0, EMPTY, -1, false, 0 };
+	fill(table.begin(), table.end(), empty);
+	tokens.clear();
+	used = 0;
+}
+
+double MembershipCache::hitRate() const {
+	unsigned long long lookups = hitCount + missCount;
+	return lookups == 0 ? 0 : (double)hitCount / lookups;
+}
+
+// Slot holding w, or the empty slot where w belongs
+size_t MembershipCache::probe(const vector<symbol> &w, uint64_t f) const {
+	size_t mask = table.size() - 1;
+	for (size_t i = f & mask;; i = (i + 1) & mask){
+		const Entry &e = table[i];
+		if (e.length == EMPTY)
+			return i;
+		// The empty string has no tokens to compare, and w.data() may be null for it
+		if (e.fingerprint == f && e.length == w.size()
+			&& (e.length == 0 || memcmp(tokens.data() + e.start, w.data(), w.size() * sizeof(symbol)) == 0))
+			return i;
+	}
+}
+
+void MembershipCache::grow(){
+	vector<Entry> old;
+	old.swap(table);
+	Entry empty = { 0, 0, EMPTY, -1, false, 0 };
+	table.assign(old.size() * 2, empty);
+	size_t mask = table.size() - 1;
+	for (const Entry &e : old){
+		if (e.length == EMPTY)
+			continue;
+		size_t i = e.fingerprint & mask;
+		while (table[i].length != EMPTY)
+			i = (i + 1) & mask;
+		table[i] = e;
+	}
+}
+
+signed char &MembershipCache::lookup(const vector<symbol> &w){
+	bool found;
+	signed char &answer = slot(w, found);
+	if (found)
+		hitCount++;
+	else
+		missCount++;
+	return answer;
+}
+
+int MembershipCache::find(const vector<symbol> &w) const {
+	const Entry &e = table[probe(w, fingerprint(w))];
+	return e.length == EMPTY ? -1 : e.answer;
+}
+
+void MembershipCache::add(const vector<symbol> &w, bool answer){
+	bool found;
+	signed char &a = slot(w, found);
+	if (a < 0)
+		a = answer;
+}
+
+// Drops entries until table and tokens take at most half of maxBytes, in the order
+// membership.h gives
+void MembershipCache::evict(){
+	size_t size = table.size();
+	while (size > 1024 && size * sizeof(Entry) > maxBytes / 4)
+		size /= 2;
+	size_t budget = maxBytes / 2 > size * sizeof(Entry) ? maxBytes / 2 - size * sizeof(Entry) : 0;
+
+	vector<const Entry*> live;
+	live.reserve(used);
+	for (const Entry &e : table)
+		if (e.length != EMPTY)
+			live.push_back(&e);
+	unsigned short g = generation;
+	auto rank = [g](const Entry* e){ return e->generation != g ? 2 : e->found ? 0 : 1; };
+	sort(live.begin(), live.end(), [&rank](const Entry* a, const Entry* b){
+		int ra = rank(a), rb = rank(b);
+		return ra != rb ? ra < rb : a->start > b->start;
+	});
+
+	vector<symbol> kept;
+	vector<Entry> old;
+	old.swap(table);
+	Entry empty = { 0, 0, EMPTY, -1, false, 0 };
+	table.assign(size, empty);
+	size_t mask = size - 1;
+	used = 0;
+	for (const Entry* e : live){
+		if ((kept.size() + e->length) * sizeof(symbol) > budget || (used + 1) * 2 > size)
+			break;
+		size_t i = e->fingerprint & mask;
+		while (table[i].length != EMPTY)
+			i = (i + 1) & mask;
+		table[i] = *e;
+		table[i].start = kept.size();
+		table[i].found = false;
+		kept.insert(kept.end(), tokens.begin() + e->start, tokens.begin() + e->start + e->length);
+		used++;
+	}
+	tokens.swap(kept);
+	generation++;
+}
+
+// w's entry, which is added (with answer -1) if found comes back false
+signed char &MembershipCache::slot(const vector<symbol> &w, bool &found){
+	uint64_t f = fingerprint(w);
+	size_t i = probe(w, f);
+	found = table[i].length != EMPTY;
+	if (found){
+		table[i].found = true;
+		table[i].generation = generation;
+		return table[i].answer;
+	}
+
+	bool full = (used + 1) * 2 > table.size();
+	size_t need = (tokens.size() + w.size()) * sizeof(symbol) + (full ? 2 : 1) * table.size() * sizeof(Entry);
+	if (need > maxBytes && used > 0){
+		evict();
+		full = (used + 1) * 2 > table.size();
+		i = probe(w, f);
+	}
+	if (full){
+		grow();
+		i = probe(w, f);
+	}
+
+	Entry &e = table[i];
+	e.fingerprint = f;
+	e.start = tokens.size();
+	e.length = w.size();
+	e.answer = -1;
+	e.found = false;
+	e.generation = generation;
+	tokens.insert(tokens.end(), w.begin(), w.end());
+	used++;
+	return e.answer;
+}
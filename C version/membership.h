@@ -0,0 +1,80 @@
+#ifndef _MEMBERSHIP_
+#define _MEMBERSHIP_
+
+#include <cstdint>
+#include <vector>
+
+#include "symbols.h"
+
+using namespace::std;
+
+// Answers of earlier membership queries, keyed on token id sequences
+//
+// An open addressing table of 64 bit fingerprints.  Each entry points at its tokens in
+// one shared array, and a matching fingerprint is confirmed by comparing the tokens,
+// so two different strings can never share an answer.  lookup() finds a string's
+// entry or adds an empty one in the same probe, so a query is checked and recorded
+// with one hash of the string.
+//
+// Table and tokens together are kept under maxBytes: an insert that would go over
+// first evicts down to half of it.  Entries found again since the last eviction are
+// kept first, then the others added since, then the rest, newest first within each, so
+// the strings the learner keeps asking about stay while ones it has moved past go.
+class MembershipCache{
+public:
+	MembershipCache(size_t maxBytes = (size_t)1 << 28);
+	// The answer for w: 0 or 1 if w has been answered, -1 if w was just added
+	// The caller stores the answer in the returned slot before the next lookup
+	signed char &lookup(const vector<symbol> &w);
+	// The answer for w (-1 if there is none yet) without adding w or counting a lookup
+	int find(const vector<symbol> &w) const;
+	// Records an answer for w, if it has none yet, without counting a lookup
+	void add(const vector<symbol> &w, bool answer);
+	// Calls f(w, answer) for every string that has an answer
+	template <class F>
+	void forEach(F f) const {
+		vector<symbol> w;
+		for (auto &e : table)
+			if (e.length != EMPTY && e.answer >= 0){
+				w.assign(tokens.begin() + e.start, tokens.begin() + e.start + e.length);
+				f(w, e.answer != 0);
+			}
+	}
+	void clear();
+	void setLimit(size_t bytes){ maxBytes = bytes; }
+	size_t size() const { return used; }
+	size_t bytes() const { return table.size() * sizeof(Entry) + tokens.size() * sizeof(symbol); }
+	unsigned long long hits() const { return hitCount; }
+	unsigned long long misses() const { return missCount; }
+	double hitRate() const;
+private:
+	struct Entry{
+		uint64_t fingerprint;
+		size_t start;		// first token in tokens
+		unsigned int length;	// EMPTY for an unused slot
+		signed char answer;
+		bool found;			// by a lookup since it was added or last kept
+		unsigned short generation;	// of the last lookup that found or added it
+	};
+	static const unsigned int EMPTY = ~0u;
+
+	vector<Entry> table;	// size is a power of two, at most half full
+	vector<symbol> tokens;
+	size_t used;
+	size_t maxBytes;
+	unsigned short generation;	// evictions so far
+	unsigned long long hitCount, missCount;
+
+	size_t probe(const vector<symbol> &w, uint64_t f) const;
+	signed char &slot(const vector<symbol> &w, bool &found);
+	void grow();
+	void evict();
+};
+
+// 64 bit fingerprint of a token id sequence
+uint64_t fingerprint(const vector<symbol> &w);
+
+// Final mix of MurmurHash3, every input bit affects every output bit
+uint64_t mix64(uint64_t x);
+
+#endif
@@ -0,0 +1,90 @@
+#include "observation.h"
+
+ObservationTable::ObservationTable(CFG* t)
+	: target(t), featureVersion(0) {}
+
+void ObservationTable::setFeatures(const vector<context> &F){
+	vector<unsigned int> old;
+	old.swap(featureColumns);
+	for (auto &c : F){
+		auto found = columns.emplace(make_pair(c.lhs, c.rhs), contexts.size());
+		if (found.second)
+			contexts.push_back(c);
+		featureColumns.push_back(found.first->second);
+	}
+	featureBits.assign(bitWords(contexts.size()), 0);
+	for (unsigned int f : featureColumns)
+		setBit(featureBits.data(), f);
+	if (featureColumns != old)
+		featureVersion++;
+}
+
+unsigned int ObservationTable::rowOf(const vector<symbol> &w){
+	auto found = rowIds.emplace(w, strings.size());
+	if (found.second){
+		strings.push_back(w);
+		cells.push_back(Row());
+	}
+	return found.first->second;
+}
+
+// Asks the oracle every cell of rows rs under a feature that has no answer yet
+void ObservationTable::fill(const vector<unsigned int> &rs){
+	unsigned int words = bitWords(contexts.size());
+	vector<vector<symbol>> queries;
+	vector<pair<unsigned int, unsigned int>> asked;	// (row, column) of each query
+	for (unsigned int r : rs){
+		Row &row = cells[r];
+		row.in.resize(words, 0);
+		row.known.resize(words, 0);
+		const vector<symbol> &w = strings[r];
+		for (unsigned int f : featureColumns){
+			if (testBit(row.known.data(), f))
+				continue;
+			setBit(row.known.data(), f);	// also keeps a row repeated in rs from asking twice
+			// odot operation: left side of the context, string, right side of context
+			vector<symbol> lur;
+			lur.reserve(contexts[f].lhs.size() + w.size() + contexts[f].rhs.size());
+			lur.insert(lur.end(), contexts[f].lhs.begin(), contexts[f].lhs.end());
+			lur.insert(lur.end(), w.begin(), w.end());
+			lur.insert(lur.end(), contexts[f].rhs.begin(), contexts[f].rhs.end());
+			queries.push_back(lur);
+			asked.push_back(make_pair(r, f));
+		}
+	}
+	if (queries.empty())
+		return;
+
+	// Test which lur are in the language, all at once
+	vector<word> in = target->acceptsBatch(queries);
+	for (size_t q = 0; q < asked.size(); q++)
+		if (testBit(in.data(), q))
+			setBit(cells[asked[q].first].in.data(), asked[q].second);
+}
+
+vector<context> ObservationTable::features(unsigned int r) const {
+	vector<context> result;
+	for (unsigned int f : featureColumns)
+		if (testBit(cells[r].in.data(), f))
+			result.push_back(contexts[f]);
+	return result;
+}
+
+vector<context> ObservationTable::row(const vector<symbol> &w){
+	vector<unsigned int> rs(1, rowOf(w));
+	fill(rs);
+	return features(rs[0]);
+}
+
+bool ObservationTable::included(const vector<symbol> &u, const vector<symbol> &v){
+	vector<unsigned int> rs;
+	rs.push_back(rowOf(u));
+	rs.push_back(rowOf(v));
+	fill(rs);
+	const word* a = cells[rs[0]].in.data();
+	const word* b = cells[rs[1]].in.data();
+	for (unsigned int k = 0; k < featureBits.size(); k++)
+		if (a[k] & featureBits[k] & ~b[k])
+			return false;
+	return true;
+}
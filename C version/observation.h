@@ -0,0 +1,58 @@
+#ifndef _OBSERVATION_
+#define _OBSERVATION_
+
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "grammars.h"
+#include "types.h"
+
+using namespace::std;
+
+// Clark's observation table: one row per substring, one column per context, and
+// one membership bit per cell, telling whether lhs w rhs is in the target language
+//
+// Rows and columns are only ever added, and a cell is asked for the first time
+// its row is read while its context is one of the current features, so the table
+// can be kept for the whole run and each sample only pays for its new cells.
+class ObservationTable{
+public:
+	ObservationTable(CFG* target);
+	// The contexts F a row lookup reports, in the order of F
+	void setFeatures(const vector<context> &F);
+	// FL(F, w): the features that w has
+	vector<context> row(const vector<symbol> &w);
+	// Whether every feature u has is a feature of v too
+	bool included(const vector<symbol> &u, const vector<symbol> &v);
+
+	// Row level access, for callers that keep row numbers
+	unsigned int rowOf(const vector<symbol> &w);	// adds an empty row for a new w
+	void fill(const vector<unsigned int> &rs);	// asks every unanswered feature cell of rs in one batch
+	// Cells of filled row r that are in the language, over all columns (mask with featureMask())
+	const word* bits(unsigned int r) const { return cells[r].in.data(); }
+	vector<context> features(unsigned int r) const;
+	const vector<word> &featureMask() const { return featureBits; }
+	unsigned int words() const { return featureBits.size(); }
+	// Changes whenever setFeatures() is given a different F
+	unsigned int version() const { return featureVersion; }
+	size_t rowCount() const { return cells.size(); }
+	size_t columnCount() const { return contexts.size(); }
+private:
+	struct Row{
+		vector<word> in;	// the answered cells that are in the language
+		vector<word> known;	// the cells answered so far
+	};
+
+	CFG* target;
+	vector<context> contexts;				// column -> context
+	map<pair<vector<symbol>, vector<symbol>>, unsigned int> columns;
+	vector<unsigned int> featureColumns;			// columns of F
+	vector<word> featureBits;				// the same, as a bitset
+	unsigned int featureVersion;
+	map<vector<symbol>, unsigned int> rowIds;
+	vector<vector<symbol>> strings;				// row -> substring
+	vector<Row> cells;
+};
+
+#endif
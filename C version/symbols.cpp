@@ -0,0 +1,27 @@
+#include "symbols.h"
+
+SymbolTable terminals;
+
+// Returns the id of s, giving it the next free id if it is new
+symbol SymbolTable::intern(const string &s){
+	auto it = ids.find(s);
+	if (it != ids.end())
+		return it->second;
+	symbol id = names.size();
+	ids.emplace(s, id);
+	names.push_back(s);
+	return id;
+}
+
+void SymbolTable::reserve(size_t n){
+	ids.reserve(n);
+	names.reserve(n);
+}
+
+// Returns the id of s, or -1 if s has never been interned
+int SymbolTable::find(const string &s) const{
+	auto it = ids.find(s);
+	if (it == ids.end())
+		return -1;
+	return it->second;
+}
@@ -0,0 +1,74 @@
+#include "threadpool.h"
+
+static thread_local int loopWorker = -1;	// worker id of this thread while it runs a loop
+
+ThreadPool::ThreadPool(unsigned int threads)
+	: job(NULL), count(0), next(0), active(0), generation(0), stopping(false) {
+	if (threads == 0)
+		threads = max(1u, thread::hardware_concurrency());
+	for (unsigned int i = 1; i < threads; i++)
+		workers.push_back(thread(&ThreadPool::work, this, i));
+}
+
+ThreadPool::~ThreadPool(){
+	{
+		unique_lock<mutex> guard(lock);
+		stopping = true;
+	}
+	wake.notify_all();
+	for (auto &t : workers)
+		t.join();
+}
+
+void ThreadPool::run(unsigned int worker){
+	for (size_t i = next++; i < count; i = next++)
+		(*job)(worker, i);
+}
+
+void ThreadPool::work(unsigned int worker){
+	loopWorker = worker;
+	unsigned int seen = 0;
+	unique_lock<mutex> guard(lock);
+	for (;;){
+		wake.wait(guard, [&]{ return stopping || generation != seen; });
+		if (stopping)
+			return;
+		seen = generation;
+		guard.unlock();
+		run(worker);
+		guard.lock();
+		if (--active == 0)
+			done.notify_one();
+	}
+}
+
+void ThreadPool::parallelFor(size_t n, const function<void(unsigned int, size_t)> &f){
+	if (workers.empty() || n < 2 || loopWorker >= 0){
+		unsigned int worker = loopWorker < 0 ? 0 : loopWorker;
+		for (size_t i = 0; i < n; i++)
+			f(worker, i);
+		return;
+	}
+	unique_lock<mutex> serial(calls);
+	unique_lock<mutex> guard(lock);
+	job = &f;
+	count = n;
+	next = 0;
+	active = workers.size();
+	generation++;
+	guard.unlock();
+	wake.notify_all();
+
+	loopWorker = 0;
+	run(0);
+	loopWorker = -1;
+
+	guard.lock();
+	done.wait(guard, [&]{ return active == 0; });
+	job = NULL;
+}
+
+ThreadPool &sharedPool(){
+	static ThreadPool pool;
+	return pool;
+}
@@ -0,0 +1,44 @@
+#ifndef _THREADPOOL_
+#define _THREADPOOL_
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace::std;
+
+// Fixed set of worker threads for parallel loops over independent tasks
+// The calling thread works too, as worker 0, so a pool of one thread runs loops inline.
+class ThreadPool{
+public:
+	ThreadPool(unsigned int threads = 0);	// 0: one thread per hardware thread
+	~ThreadPool();
+	unsigned int size() const { return workers.size() + 1; }
+	// Calls f(worker, i) for i = 0 .. n-1 and returns when they are all done
+	// worker is in 0 .. size()-1, so f can keep state per thread.  A loop started from
+	// inside another loop runs inline, with the worker id of the thread that started it.
+	void parallelFor(size_t n, const function<void(unsigned int, size_t)> &f);
+private:
+	vector<thread> workers;
+	mutex lock;
+	mutex calls;			// one loop at a time
+	condition_variable wake;
+	condition_variable done;
+	const function<void(unsigned int, size_t)>* job;
+	size_t count;
+	atomic<size_t> next;
+	unsigned int active;		// workers still on the current loop
+	unsigned int generation;	// loops started so far
+	bool stopping;
+
+	void run(unsigned int worker);
+	void work(unsigned int worker);
+};
+
+// Pool shared by the whole program, started on first use
+ThreadPool &sharedPool();
+
+#endif
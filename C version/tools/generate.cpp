@@ -0,0 +1,295 @@
+/****************************************************************
+ * File: tools/generate.cpp
+ * Random sentences of a weighted grammar, written as samples the
+ * learner reads, for corpora far bigger than a grammar's own
+ ****************************************************************
+ * Build from the "C version" directory:
+ *   g++ -std=c++11 -O2 -I. tools/generate.cpp binaryio.cpp cachefile.cpp
+ *       cyk.cpp cykCBFG.cpp featuresets.cpp grammarfile.cpp grammars.cpp
+ *       membership.cpp prefixchart.cpp symbols.cpp threadpool.cpp
+ *       types.cpp valiant.cpp -o generate -lpthread
+ * Run:
+ *   generate grammar [-n count] [--seed s] [--min-length n]
+ *       [--max-length n] [--unique] [--with-grammar] [-o file]
+ * Writes count sentences (1000 by default), one per line, ready for
+ * --stream or a grammar's samples section.  With --with-grammar the
+ * text grammar comes first, its own samples replaced by these, so
+ * the output can be given to clarketal10_ as it is.
+ *
+ * Rules are weighted as extract reads them (A,a,0.25 or A,B,C,0.5,
+ * 1 when not given), and each nonterminal picks among its rules
+ * with Vose's alias method: one 64 bit draw and one table lookup a
+ * rule, however many rules there are.  The same seed and options
+ * always give the same sentences.
+ *
+ * A sentence outside the length limits (1 and 100 by default) is
+ * dropped and drawn again.  A derivation is dropped as soon as the
+ * shortest sentence it can still make is too long, so long ones
+ * cost no more than the limit.  --unique drops repeated sentences
+ * too.  After 100000 draws in a row are dropped the grammar is
+ * taken to have no more sentences to give, and it stops short.
+ ****************************************************************/
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../grammarfile.h"
+#include "../grammars.h"
+#include "../membership.h"
+
+using namespace::std;
+
+static const uint64_t NEVER = ~0ull >> 2;	// the shortest yield of an unproductive symbol
+
+// One slot of an alias table: its own rule is taken for a fraction below threshold
+// (out of 2^32), alias otherwise
+typedef struct{
+	uint64_t threshold;
+	unsigned int alias;
+} Slot;
+
+// Vose's alias method over weights w, whose sum must be above 0
+void buildAlias(const vector<double> &w, Slot* slots){
+	unsigned int n = w.size();
+	double total = 0;
+	for (double x : w)
+		total += x;
+	vector<double> p(n);
+	vector<unsigned int> small, large;
+	for (unsigned int i = 0; i < n; i++){
+		p[i] = w[i] * n / total;
+		(p[i] < 1 ? small : large).push_back(i);
+	}
+	while (!small.empty() && !large.empty()){
+		unsigned int s = small.back(), l = large.back();
+		small.pop_back();
+		slots[s].threshold = (uint64_t)(p[s] * 4294967296.0);
+		slots[s].alias = l;
+		p[l] -= 1 - p[s];
+		if (p[l] < 1){
+			large.pop_back();
+			small.push_back(l);
+		}
+	}
+	// What is left is 1 up to rounding
+	for (unsigned int i : large)
+		slots[i] = { (uint64_t)1 << 32, i };
+	for (unsigned int i : small)
+		slots[i] = { (uint64_t)1 << 32, i };
+}
+
+// The grammar's rules grouped by left side, each right side as items: a terminal t
+// is t * 2 + 1, a nonterminal A is A * 2
+class Generator{
+public:
+	Generator(const CFG &G, const RuleWeights &weights);
+	bool productive() const { return shortest[start] < NEVER; }
+	// Draws a sentence into w, or returns false if it left the length limits
+	bool sentence(mt19937_64 &rng, unsigned int minLength, unsigned int maxLength, vector<symbol> &w);
+private:
+	typedef struct{
+		unsigned int first, length;	// its items
+		uint64_t shortest;		// its shortest yield
+	} Rule;
+
+	symbol start;
+	vector<unsigned int> firstRule;	// nonterminal -> its first rule, its rules follow
+	vector<Rule> rules;
+	vector<unsigned int> items;
+	vector<Slot> slots;		// one per rule, a nonterminal's rules' slots together
+	vector<uint64_t> shortest;	// nonterminal -> its shortest yield
+	vector<unsigned int> stack;
+};
+
+Generator::Generator(const CFG &G, const RuleWeights &weights)
+	: start(G.start) {
+	unsigned int nt = G.nonterminals.size();
+	vector<vector<vector<unsigned int>>> rhs(nt);
+	vector<vector<double>> w(nt);
+	for (size_t i = 0; i < G.rules.PL.size(); i++){
+		rhs[G.rules.PL[i].left].push_back({ G.rules.PL[i].right * 2 + 1 });
+		w[G.rules.PL[i].left].push_back(weights.PL[i]);
+	}
+	for (size_t i = 0; i < G.rules.P.size(); i++){
+		rhs[G.rules.P[i].left].push_back({ G.rules.P[i].one * 2, G.rules.P[i].two * 2 });
+		w[G.rules.P[i].left].push_back(weights.P[i]);
+	}
+
+	// Rules of weight 0 are left out, so they are never picked
+	for (symbol A = 0; A < nt; A++){
+		firstRule.push_back(rules.size());
+		vector<double> kept;
+		for (size_t r = 0; r < rhs[A].size(); r++)
+			if (w[A][r] > 0){
+				Rule rule = { (unsigned int)items.size(), (unsigned int)rhs[A][r].size(), NEVER };
+				items.insert(items.end(), rhs[A][r].begin(), rhs[A][r].end());
+				rules.push_back(rule);
+				kept.push_back(w[A][r]);
+			}
+		slots.resize(rules.size());
+		if (!kept.empty())
+			buildAlias(kept, &slots[firstRule[A]]);
+	}
+	firstRule.push_back(rules.size());
+
+	// Shortest yields, to a fixpoint
+	shortest.assign(nt, NEVER);
+	bool changed = true;
+	while (changed){
+		changed = false;
+		for (symbol A = 0; A < nt; A++)
+			for (unsigned int r = firstRule[A]; r < firstRule[A + 1]; r++){
+				uint64_t length = 0;
+				for (unsigned int i = 0; i < rules[r].length; i++){
+					unsigned int item = items[rules[r].first + i];
+					length += item & 1 ? 1 : shortest[item >> 1];
+				}
+				rules[r].shortest = min(length, NEVER);
+				if (rules[r].shortest < shortest[A]){
+					shortest[A] = rules[r].shortest;
+					changed = true;
+				}
+			}
+	}
+}
+
+// Expands the leftmost nonterminal each time, so terminals come out in order.
+// bound is the length of w plus the shortest yield of what is still on the stack,
+// the shortest the sentence can still be.
+bool Generator::sentence(mt19937_64 &rng, unsigned int minLength, unsigned int maxLength, vector<symbol> &w){
+	w.clear();
+	stack.assign(1, start * 2);
+	uint64_t bound = shortest[start];
+	while (!stack.empty()){
+		unsigned int item = stack.back();
+		stack.pop_back();
+		if (item & 1){
+			w.push_back(item >> 1);
+			continue;
+		}
+		symbol A = item >> 1;
+		unsigned int n = firstRule[A + 1] - firstRule[A];
+		uint64_t draw = rng();
+		unsigned int slot = ((draw >> 32) * n) >> 32;
+		const Slot &s = slots[firstRule[A] + slot];
+		const Rule &rule = rules[firstRule[A] + ((draw & 0xffffffff) < s.threshold ? slot : s.alias)];
+		bound += rule.shortest - shortest[A];
+		if (bound > maxLength)
+			return false;
+		for (unsigned int i = rule.length; i > 0; i--)
+			stack.push_back(items[rule.first + i - 1]);
+	}
+	return w.size() >= minLength;
+}
+
+int main(int argc, char* argv[]){
+	if (argc < 2){
+		cout << "No input file given!" << endl;
+		return 1;
+	}
+	unsigned long long count = 1000;
+	unsigned long long seed = 1;
+	unsigned int minLength = 1, maxLength = 100;
+	bool unique = false, withGrammar = false;
+	string output;
+	for (int i = 2; i < argc; i++){
+		string arg = argv[i];
+		if (arg == "--unique")
+			unique = true;
+		else if (arg == "--with-grammar")
+			withGrammar = true;
+		else if (i + 1 < argc && arg == "-n")
+			count = strtoull(argv[++i], NULL, 10);
+		else if (i + 1 < argc && arg == "--seed")
+			seed = strtoull(argv[++i], NULL, 10);
+		else if (i + 1 < argc && arg == "--min-length")
+			minLength = atoi(argv[++i]);
+		else if (i + 1 < argc && arg == "--max-length")
+			maxLength = atoi(argv[++i]);
+		else if (i + 1 < argc && arg == "-o")
+			output = argv[++i];
+		else{
+			cout << "Unknown option " << arg << endl;
+			return 1;
+		}
+	}
+	if (withGrammar && isBinaryGrammar(argv[1])){
+		cout << "--with-grammar needs a text grammar" << endl;
+		return 1;
+	}
+
+	RuleWeights weights;
+	CFG* G = extract(argv[1], &weights);
+	if (G == NULL)
+		return 1;
+	Generator generator(*G, weights);
+	if (!generator.productive()){
+		cout << "The start symbol derives no sentence" << endl;
+		return 1;
+	}
+
+	ios::sync_with_stdio(false);
+	ofstream file;
+	if (!output.empty()){
+		file.open(output.c_str(), ios::binary | ios::trunc);
+		if (!file.is_open()){
+			cout << "Unable to open " << output << endl;
+			return 1;
+		}
+	}
+	ostream &out = output.empty() ? cout : file;
+
+	// Every line ends with a newline, so more can be appended with >>
+	string buffer;
+	if (withGrammar){
+		ifstream input(argv[1]);
+		string line;
+		while (getline(input, line) && line != "samples:")
+			buffer += line + "\n";
+		buffer += "samples:\n";
+	}
+
+	vector<string> names;
+	for (symbol a = 0; a < terminals.size(); a++)
+		names.push_back(terminals.name(a));
+	MembershipCache seen;
+	seen.setLimit(~(size_t)0);
+	mt19937_64 rng(seed);
+	vector<symbol> w;
+	unsigned long long made = 0, dropped = 0;
+	while (made < count && dropped < 100000){
+		if (!generator.sentence(rng, minLength, maxLength, w)){
+			dropped++;
+			continue;
+		}
+		if (unique){
+			signed char &answer = seen.lookup(w);
+			if (answer >= 0){
+				dropped++;
+				continue;
+			}
+			answer = 1;
+		}
+		dropped = 0;
+		made++;
+		for (size_t i = 0; i < w.size(); i++){
+			if (i > 0)
+				buffer += ' ';
+			buffer += names[w[i]];
+		}
+		buffer += '\n';
+		if (buffer.size() >= (1 << 20)){
+			out.write(buffer.data(), buffer.size());
+			buffer.clear();
+		}
+	}
+	out.write(buffer.data(), buffer.size());
+	out.flush();
+	if (made < count)
+		cerr << "Stopped after " << made << " sentences, 100000 draws in a row were dropped" << endl;
+	return out ? 0 : 1;
+}
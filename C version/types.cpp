@@ -5,7 +5,7 @@
 //////////////////////////////
 
 // Check if two contexts are equal
-bool equal(context a, context b){
+bool equal(const context &a, const context &b){
 	if (a.lhs.size() != b.lhs.size()
 		|| a.rhs.size() != b.rhs.size())
 		return false;
@@ -18,8 +18,8 @@ bool equal(context a, context b){
 	return true;
 }
 
-// Check if two string vectors are equal
-bool equal(vector<string> a, vector<string> b){
+// Check if two symbol vectors are equal
+bool equal(const vector<symbol> &a, const vector<symbol> &b){
 	if (a.size() != b.size())
 		return false;
 	for (unsigned int i = 0; i < a.size(); i++)
@@ -29,7 +29,7 @@ bool equal(vector<string> a, vector<string> b){
 }
 
 // Check if two context vectors are equal
-bool equal(vector<context> a, vector<context> b){
+bool equal(const vector<context> &a, const vector<context> &b){
 	if (a.size() != b.size())
 		return false;
 	for (unsigned int i = 0; i < a.size(); i++){
@@ -47,21 +47,21 @@ bool equal(vector<context> a, vector<context> b){
 }
 
 // Check if two PLCRules are equal
-bool equal(PLCRule a, PLCRule b){
-	return a.s == b.s && equal(a.c, b.c);
+bool equal(const PLCRule &a, const PLCRule &b){
+	return a.s == b.s && a.c == b.c;
 }
 
 // Check if two PCRules are equal
-bool equal(PCRule a, PCRule b){
-	return equal(a.lhs, b.lhs) && equal(a.rhs1, b.rhs1) && equal(a.rhs2, b.rhs2);
+bool equal(const PCRule &a, const PCRule &b){
+	return a.lhs == b.lhs && a.rhs1 == b.rhs1 && a.rhs2 == b.rhs2;
 }
 
 /////////////////////////////////////
 /* Vector search utility functions */
 /////////////////////////////////////
 
-// Search for a string w in vector v
-bool search(vector<string> v, string w){
+// Search for a symbol w in vector v
+bool search(const vector<symbol> &v, symbol w){
 	for (unsigned int i = 0; i < v.size(); i++)
 		if (v[i] == w)
 			return true;
@@ -69,7 +69,7 @@ bool search(vector<string> v, string w){
 }
 
 // Search for a context c in vector v
-bool search(vector<context> v, context c){
+bool search(const vector<context> &v, const context &c){
 	for (unsigned int i = 0; i < v.size(); i++)
 		if (v[i].lhs == c.lhs && v[i].rhs == c.rhs)
 			return true;
@@ -77,7 +77,7 @@ bool search(vector<context> v, context c){
 }
 
 // Search for a context in a 2d vector of contexts
-bool search(vector<vector<context>> v2, context c){
+bool search(const vector<vector<context>> &v2, const context &c){
 	for (unsigned int i = 0; i < v2.size(); i++)
 		if (search(v2[i], c))
 			return true;
@@ -85,35 +85,19 @@ bool search(vector<vector<context>> v2, context c){
 }
 
 // Search for a subset string in a list of subsets
-bool search(vector<vector<string>> v, vector<string> s){
+bool search(const vector<vector<symbol>> &v, const vector<symbol> &s){
 	for (unsigned int i = 0; i < v.size(); i++)
 		if (equal(v[i], s))
 			return true;
 	return false;
 }
 
-// Search for a PLC rule in a list of PLC rules
-bool search(vector<PLCRule> rules, PLCRule r){
-	for (unsigned int i = 0; i < rules.size(); i++)
-		if (equal(rules[i], r))
-			return true;
-	return false;
-}
-
-// Search for a PC rule in a list of PC Rules
-bool search(vector<PCRule> rules, PCRule r){
-	for (unsigned int i = 0; i < rules.size(); i++)
-		if (equal(rules[i], r))
-			return true;
-	return false;
-}
-
 //////////////////////////////
 /* Subset utility functions */
 //////////////////////////////
 
 // Check if a set of contexts c1 is a subset of c2
-bool subset(vector<context> c1, vector<context> c2){
+bool subset(const vector<context> &c1, const vector<context> &c2){
 	for (unsigned int i = 0; i < c1.size(); i++)
 		if (!search(c2, c1[i]))
 			return false;
@@ -121,7 +105,7 @@ bool subset(vector<context> c1, vector<context> c2){
 }
 
 // Check if a set of contexts c1 is contained within cl
-bool subset(vector<context> c1, vector<vector<context>> cl){
+bool subset(const vector<context> &c1, const vector<vector<context>> &cl){
 	bool contained = false;
 	for (unsigned int i = 0; i < c1.size(); i++){
 		contained = false;
@@ -132,4 +116,4 @@ bool subset(vector<context> c1, vector<vector<context>> cl){
 		if (!contained) break;
 	}
 	return contained;
-}
\ No newline at end of file
+}
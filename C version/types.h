@@ -1,22 +1,28 @@
 #ifndef _TYPES_
 #define _TYPES_
 
+#include <cstdint>
+#include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
+#include "bitset.h"
+#include "symbols.h"
+
 using namespace::std;
 
 // PL CFG Rule
 typedef struct{
-	string left;
-	string right;
+	symbol left;	// nonterminal
+	symbol right;	// terminal
 } PLRule;
 
 // P CFG Rule
 typedef struct{
-	string left;
-	string one;
-	string two;
+	symbol left;
+	symbol one;
+	symbol two;
 } PRule;
 
 // Set of CFG Rules
@@ -25,23 +31,99 @@ struct CFGRules{
 	vector<PRule> P;
 };
 
+// Weights of a grammar's rules, in the order of CFGRules' vectors
+// A rule is picked in proportion to its weight among the rules with its left side
+struct RuleWeights{
+	vector<double> PL;
+	vector<double> P;
+};
+
+// One (C, {A}) entry of the binary rules A -> B C that share a left child B
+typedef struct{
+	symbol right;		// C
+	unsigned int parents;	// offset of the {A} bitset in GrammarIndex::parentSets
+} BinaryEntry;
+
+// A run of T kept alive by something else: a vector, or a file mapped into memory
+template <class T>
+struct Span{
+	Span() : first(NULL), count(0) {}
+	Span(const T* p, size_t n) : first(p), count(n) {}
+	Span(const vector<T> &v) : first(v.data()), count(v.size()) {}
+	const T* data() const { return first; }
+	size_t size() const { return count; }
+	const T &operator[](size_t i) const { return first[i]; }
+	const T* begin() const { return first; }
+	const T* end() const { return first + count; }
+	const T* first;
+	size_t count;
+};
+
+// One slot of GrammarIndex::pairs, an open addressing table over (B, C) pairs
+// The layout is the same in memory and in a binary grammar file
+typedef struct{
+	uint64_t key;		// B << 32 | C, or EMPTY_PAIR
+	unsigned int parents;	// offset of the {A} bitset in GrammarIndex::parentSets
+	unsigned int unused;
+} PairSlot;
+const uint64_t EMPTY_PAIR = ~(uint64_t)0;
+
+// Slot a probe for key starts at, in a table of mask + 1 slots
+inline size_t pairSlot(uint64_t key, size_t mask){
+	return (size_t)((key * 0x9e3779b97f4a7c15ULL) >> 32) & mask;
+}
+
+// The arrays of a GrammarIndex made by buildIndex, which its copies share
+struct GrammarTables{
+	vector<unsigned int> lexicon;
+	vector<word> lexicalSets;
+	vector<PairSlot> pairs;
+	vector<unsigned int> firstEntry;
+	vector<BinaryEntry> entries;
+	vector<word> parentSets;
+};
+
+// Lookup tables over a CFG so the CYK engines only touch the rules that can fire
+// The arrays point into storage, which copies of the index share: the GrammarTables it
+// was built in, or the binary grammar file it was mapped from (see grammarfile.h)
+struct GrammarIndex{
+	GrammarIndex() : nonterminals(0), ntWords(0) {}
+	const word* lexical(symbol a) const;		// {A | A -> a}, NULL if there is none
+	const word* parents(symbol B, symbol C) const;	// {A | A -> B C}, NULL if there is none
+	Span<BinaryEntry> byLeft(symbol B) const {	// every (C, {A}) with A -> B C
+		return Span<BinaryEntry>(entries.data() + firstEntry[B], firstEntry[B + 1] - firstEntry[B]);
+	}
+	void use(const shared_ptr<const GrammarTables> &tables);	// points every array into tables
+	unsigned int nonterminals;	// nonterminal ids are 0 .. nonterminals-1
+	unsigned int ntWords;		// words in a bitset over nonterminals
+	Span<unsigned int> lexicon;	// terminal a -> offset of {A | A -> a}, NONE if a has no rule
+	Span<word> lexicalSets;		// those {A} bitsets, ntWords words each, shared by equal sets
+	Span<PairSlot> pairs;		// (B, C) -> offset of {A | A -> B C}, a power of two slots at most half full
+	Span<unsigned int> firstEntry;	// B -> B's first entry, then one past the last B's last
+	Span<BinaryEntry> entries;	// every (C, {A}) with A -> B C, grouped by B
+	Span<word> parentSets;		// the {A} bitsets, ntWords words each
+	shared_ptr<const void> storage;	// what the arrays point into
+	static const unsigned int NONE = ~0u;
+};
+
 // A single context
 typedef struct{
-	vector<string> lhs;
-	vector<string> rhs;
+	vector<symbol> lhs;
+	vector<symbol> rhs;
 } context;
 
 // PL Contextual (CBFG) Rule
+// Feature sets are ids in featureSets (see featuresets.h)
 typedef struct{
-	vector<context> c;
-	string s;
+	unsigned int c;
+	symbol s;
 } PLCRule;
 
 // P Contextual (CBFG) Rule
 typedef struct{
-	vector<context> lhs;
-	vector<context> rhs1;
-	vector<context> rhs2;
+	unsigned int lhs;
+	unsigned int rhs1;
+	unsigned int rhs2;
 } PCRule;
 
 // Set of CBFG Rules
@@ -55,50 +137,44 @@ struct CBFGRules{
 //////////////////////////////
 
 // Check if two contexts are equal
-bool equal(context a, context);
+bool equal(const context &a, const context &b);
 
-// Check if two string vectors are equal
-bool equal(vector<string> a, vector<string> b);
+// Check if two symbol vectors are equal
+bool equal(const vector<symbol> &a, const vector<symbol> &b);
 
 // Check if two context vectors are equal
-bool equal(vector<context> a, vector<context> b);
+bool equal(const vector<context> &a, const vector<context> &b);
 
 // Check if two PLCRules are equal
-bool equal(PLCRule a, PLCRule b);
+bool equal(const PLCRule &a, const PLCRule &b);
 
 // Check if two PCRules are equal
-bool equal(PCRule a, PCRule b);
+bool equal(const PCRule &a, const PCRule &b);
 
 /////////////////////////////////////
 /* Vector search utility functions */
 /////////////////////////////////////
 
-// Search for a string w in vector v
-bool search(vector<string> v, string w);
+// Search for a symbol w in vector v
+bool search(const vector<symbol> &v, symbol w);
 
 // Search for a context c in vector v
-bool search(vector<context> v, context c);
+bool search(const vector<context> &v, const context &c);
 
 // Search for a context in a 2d vector of contexts
-bool search(vector<vector<context>> v2, context c);
+bool search(const vector<vector<context>> &v2, const context &c);
 
 // Search for a subset string in a list of subsets
-bool search(vector<vector<string>> v, vector<string> s);
-
-// Search for a PLC rule in a list of PLC rules
-bool search(vector<PLCRule> rules, PLCRule r);
-
-// Search for a PC rule in a list of PC Rules
-bool search(vector<PCRule> rules, PCRule r);
+bool search(const vector<vector<symbol>> &v, const vector<symbol> &s);
 
 //////////////////////////////
 /* Subset utility functions */
 //////////////////////////////
 
 // Check if a set of contexts c1 is a subset of c2
-bool subset(vector<context> c1, vector<context> c2);
+bool subset(const vector<context> &c1, const vector<context> &c2);
 
 // Check if a set of contexts c1 is contained within cl
-bool subset(vector<context> c1, vector<vector<context>> cl);
+bool subset(const vector<context> &c1, const vector<vector<context>> &cl);
 
 #endif
\ No newline at end of file
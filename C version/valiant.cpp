@@ -0,0 +1,113 @@
+#include "valiant.h"
+
+// Mask of the bits of word k that fall in the column range [c0, c1)
+static word rangeMask(unsigned int k, unsigned int c0, unsigned int c1){
+	unsigned int lo = k * 64, hi = lo + 64;
+	word mask = ~(word)0;
+	if (c0 > lo)
+		mask &= ~(word)0 << (c0 - lo);
+	if (c1 < hi)
+		mask &= ~(word)0 >> (hi - c1);
+	return mask;
+}
+
+ValiantRecognizer::ValiantRecognizer(const GrammarIndex &i)
+	: index(i), N(0), R(0) {
+	for (symbol B = 0; B < index.nonterminals; B++)
+		for (const BinaryEntry &e : index.byLeft(B)){
+			Pair p;
+			p.left = B;
+			p.right = e.right;
+			p.parents = e.parents;
+			pairs.push_back(p);
+		}
+}
+
+// P[r0..r1) x [c0..c1) |= T[r0..r1) x [k0..k1) * T[k0..k1) x [c0..c1), for every pair
+// Row i of the product is the OR of the rows k of T_C picked out by row i of T_B,
+// so each step is a run of word-wide ORs over the block's columns.  Pairs that share
+// a left child B share the scan of T_B.
+void ValiantRecognizer::multiply(unsigned int r0, unsigned int r1, unsigned int k0, unsigned int k1,
+	unsigned int c0, unsigned int c1)
+{
+	unsigned int kw0 = k0 / 64, kw1 = (k1 - 1) / 64;
+	unsigned int cw0 = c0 / 64, cw1 = (c1 - 1) / 64;
+	for (unsigned int first = 0, last; first < pairs.size(); first = last){
+		symbol B = pairs[first].left;
+		for (last = first; last < pairs.size() && pairs[last].left == B; last++);
+		for (unsigned int i = r0; i < r1; i++){
+			const word* b = Trow(B, i);
+			for (unsigned int kw = kw0; kw <= kw1; kw++){
+				word x = b[kw] & rangeMask(kw, k0, k1);
+				while (x){
+					unsigned int k = kw * 64 + lowestBit(x);
+					x &= x - 1;
+					for (unsigned int p = first; p < last; p++){
+						const word* c = Trow(pairs[p].right, k);
+						word* out = Prow(p, i);
+						for (unsigned int cw = cw0; cw <= cw1; cw++)
+							out[cw] |= c[cw] & rangeMask(cw, c0, c1);
+					}
+				}
+			}
+		}
+	}
+}
+
+// Fills every T[i][j] with l <= i < j < m
+void ValiantRecognizer::compute(unsigned int l, unsigned int m){
+	if (m - l >= 4){
+		compute(l, (l + m) / 2);
+		compute((l + m) / 2, m);
+	}
+	complete(l, (l + m) / 2, (l + m) / 2, m);
+}
+
+// Fills the block T[l..m) x [l2..m2), given that T is known inside [l, m) and inside
+// [l2, m2), and that P of the block already holds every split point in [m, l2)
+void ValiantRecognizer::complete(unsigned int l, unsigned int m, unsigned int l2, unsigned int m2){
+	if (m - l == 1){
+		if (l2 == l + 1)	// a lexical cell
+			return;
+		for (unsigned int p = 0; p < pairs.size(); p++)
+			if (testBit(Prow(p, l), l2))
+				forEachBit(&index.parentSets[pairs[p].parents], index.ntWords, [&](unsigned int A){
+					setBit(Trow(A, l), l2);
+				});
+		return;
+	}
+	unsigned int j = (l + m) / 2, j2 = (l2 + m2) / 2;
+	complete(j, m, l2, j2);
+	multiply(l, j, j, m, l2, j2);
+	complete(l, j, l2, j2);
+	multiply(j, m, l2, j2, j2, m2);
+	complete(j, m, j2, m2);
+	multiply(l, j, j, m, j2, m2);
+	multiply(l, j, l2, j2, j2, m2);
+	complete(l, j, j2, m2);
+}
+
+void ValiantRecognizer::parse(const vector<symbol> &w, vector<word> &top){
+	unsigned int n = w.size();
+	N = 2;
+	while (N < n + 1)
+		N *= 2;
+	R = bitWords(N);
+	T.assign((size_t)index.nonterminals * N * R, 0);
+	P.assign((size_t)pairs.size() * N * R, 0);
+
+	for (unsigned int i = 0; i < n; i++){
+		const word* As = index.lexical(w[i]);
+		if (As != NULL)
+			forEachBit(As, index.ntWords, [&](unsigned int A){
+				setBit(Trow(A, i), i + 1);
+			});
+	}
+
+	compute(0, N);
+
+	top.assign(index.ntWords, 0);
+	for (symbol X = 0; X < index.nonterminals; X++)
+		if (testBit(Trow(X, 0), n))
+			setBit(top.data(), X);
+}
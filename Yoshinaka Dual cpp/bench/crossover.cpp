@@ -0,0 +1,72 @@
+/****************************************************************
+ * File: bench/crossover.cpp
+ * Times buildMatrix against the Valiant and Earley engines as the
+ * sentence length grows, to find where each overtakes CYK_MATRIX
+ ****************************************************************
+ * Build from the "Yoshinaka Dual cpp" directory:
+ *   g++ -std=c++11 -O2 -I. bench/crossover.cpp binaryio.cpp cachefile.cpp
+ *       cyke.cpp earley.cpp featuresets.cpp grammarfile.cpp membership.cpp
+ *       prefixchart.cpp symbols.cpp types.cpp valiant.cpp
+ *       threadpool.cpp -o crossover
+ * Run:
+ *   crossover [nonterminals] [rules] [max length]
+ * Output is CSV: engine,n,ns_per_query,queries
+ ****************************************************************/
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+
+#include "../cyke.h"
+#include "randomgrammar.h"
+
+using namespace::std;
+
+// Average ns per accepts() call over enough calls to fill about a tenth of a second
+// Each call gets a fresh history so nothing is answered from the cache
+double timeEngine(const CFG &G, const vector<vector<symbol>> &sentences, unsigned int &queries){
+	auto t0 = chrono::steady_clock::now();
+	double elapsed = 0;
+	queries = 0;
+	while (elapsed < 1e8 || queries < 3){
+		History h;
+		accepts(sentences[queries % sentences.size()], G, G.compiled, h);
+		queries++;
+		elapsed = chrono::duration<double, nano>(chrono::steady_clock::now() - t0).count();
+	}
+	return elapsed / queries;
+}
+
+int main(int argc, char* argv[]){
+	unsigned int nt = argc > 1 ? atoi(argv[1]) : 64;
+	unsigned int rules = argc > 2 ? atoi(argv[2]) : 512;
+	unsigned int maxLength = argc > 3 ? atoi(argv[3]) : 512;
+
+	mt19937 rng(1);
+	vector<symbol> sigma = fourTerminals();
+	CFG G = randomGrammar(nt, rules, sigma, rng);
+
+	const char* names[] = { "CYK_MATRIX", "VALIANT", "EARLEY" };
+	CYKEngine engines[] = { CYK_MATRIX, VALIANT, EARLEY };
+	bool running[] = { true, true, true };
+
+	cout << "engine,n,ns_per_query,queries" << endl;
+	for (unsigned int n = 8; n <= maxLength; n *= 2){
+		vector<vector<symbol>> sentences(8);
+		for (auto &w : sentences)
+			for (unsigned int i = 0; i < n; i++)
+				w.push_back(sigma[rng() % sigma.size()]);
+		for (int e = 0; e < 3; e++){
+			if (!running[e])
+				continue;
+			engineG = engines[e];
+			History warmup;
+			accepts(sentences[0], G, G.compiled, warmup);
+			unsigned int queries;
+			double ns = timeEngine(G, sentences, queries);
+			cout << names[e] << "," << n << "," << (long long)ns << "," << queries << endl;
+			if (ns > 2e9)	// too slow to go any longer
+				running[e] = false;
+		}
+	}
+}
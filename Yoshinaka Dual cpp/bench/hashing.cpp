@@ -0,0 +1,140 @@
+/****************************************************************
+ * File: bench/hashing.cpp
+ * Bucket occupancy and insert time of the context set and rule
+ * hashes, on the hypothesis the learner makes for a grammar
+ ****************************************************************
+ * Build from the "Yoshinaka Dual cpp" directory:
+ *   g++ -std=c++11 -O2 -I. bench/hashing.cpp binaryio.cpp cachefile.cpp
+ *       checkpoint.cpp cyke.cpp earley.cpp featuresets.cpp grammarfile.cpp
+ *       incidence.cpp learner.cpp membership.cpp prefixchart.cpp
+ *       symbols.cpp threadpool.cpp types.cpp valiant.cpp -o hashing
+ *       -lpthread
+ * Run:
+ *   hashing grammar [-f n] [--closed]
+ * Runs the dual algorithm over the grammar's samples, with -f and
+ * --closed as yoshinakadual takes them, then puts the sets it
+ * ended with into fresh tables: every set of contexts featureSets
+ * interned, and the P2C, P1C and PLC rules of the last Hf.  The
+ * old hashes (before contextSet and the rules cached their own)
+ * are run on the same items; the old P2C hash only gets the first
+ * 20000 rules, as its inserts take time quadratic in the count.
+ * Output is CSV: hash,items,buckets_used,max_bucket,probes_per_item,ns_per_insert
+ ****************************************************************/
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+
+#include "../featuresets.h"
+#include "../learner.h"
+
+using namespace::std;
+
+// A context set summed tokens over its set in iteration order
+struct OldSetHash{
+	size_t operator()(const contextSet &s) const {
+		size_t lhs = 0, rhs = 0;
+		for (auto c : s.set){
+			for (auto s : c.lhs)
+				lhs = lhs * 31 + s;
+			for (auto s : c.rhs)
+				rhs = rhs * 31 + s;
+		}
+		return (hash<size_t>()(lhs) ^ (hash<size_t>()(rhs)));
+	}
+};
+
+// A P2C held its sets by pointer and looked at the first token of the first
+// context of each
+struct OldP2C{
+	const contextSet *lhs, *rhs1, *rhs2;
+	bool operator==(const OldP2C &other) const {
+		return lhs == other.lhs && rhs1 == other.rhs1 && rhs2 == other.rhs2;
+	}
+};
+struct OldP2CHash{
+	static symbol first(const contextSet *s){
+		auto c = s->set.begin();
+		return c != s->set.end() && c->lhs.size() > 0 ? c->lhs[0] : 0;
+	}
+	size_t operator()(const OldP2C &p2c) const {
+		return (hash<symbol>()(first(p2c.lhs)) ^ ((hash<symbol>()(first(p2c.rhs1)) << 1)
+			^ (hash<symbol>()(first(p2c.rhs2))) << 1));
+	}
+};
+
+// Inserts items into a fresh set with hash H and prints how they spread over the buckets
+// probes_per_item is the mean length of the bucket an item is found in
+template <class T, class H>
+void report(const char* name, const vector<T> &items){
+	auto t0 = chrono::steady_clock::now();
+	unordered_set<T, H> set;
+	for (auto &x : items)
+		set.insert(x);
+	double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - t0).count();
+	size_t used = 0, longest = 0;
+	double probes = 0;
+	for (size_t b = 0; b < set.bucket_count(); b++){
+		size_t n = set.bucket_size(b);
+		used += n > 0;
+		longest = max(longest, n);
+		probes += (double)n * n;
+	}
+	cout << name << "," << set.size() << "," << used << "," << longest << ","
+		<< probes / max<size_t>(set.size(), 1) << "," << (long long)(ns / max<size_t>(items.size(), 1)) << endl;
+}
+
+int main(int argc, char* argv[]){
+	if (argc < 2){
+		cout << "usage: hashing grammar [-f n] [--closed]" << endl;
+		return 1;
+	}
+	CFG G = extractCFG(argv[1]);
+	int f = 1;
+	bool closed = false;
+	for (int i = 2; i < argc; i++){
+		if (string(argv[i]) == "--closed")
+			closed = true;
+		else if (string(argv[i]) == "-f" && i + 1 < argc)
+			f = atoi(argv[++i]);
+	}
+	if (f < 1){
+		cout << "-f must be at least 1" << endl;
+		return 1;
+	}
+
+	// The learner reports every Lhat check, which is not wanted here
+	ostringstream quiet;
+	streambuf* out = cout.rdbuf(quiet.rdbuf());
+	DualLearner learner(G, f, closed);
+	for (auto &w : G.samples)
+		learner.learn(w);
+	cout.rdbuf(out);
+	const CFGC &H = learner.rules();
+
+	// Every interned set as a contextSet, at its id
+	vector<contextSet> sets(featureSets.size());
+	for (unsigned int id = 0; id < featureSets.size(); id++)
+		for (auto &c : featureSets.contexts(id))
+			sets[id].add(c);
+
+	vector<OldP2C> oldP2C;
+	vector<P2C> p2c(H.sp2c.set.begin(), H.sp2c.set.end());
+	for (auto &r : p2c)
+		if (oldP2C.size() < 20000){
+			OldP2C old = { &sets[r.lhs], &sets[r.rhs1], &sets[r.rhs2] };
+			oldP2C.push_back(old);
+		}
+	vector<P1C> p1c(H.sp1c.set.begin(), H.sp1c.set.end());
+	vector<PLC> plc(H.splc.set.begin(), H.splc.set.end());
+
+	cerr << learner.samples().size() << " samples, " << sets.size() << " sets, " << p2c.size()
+		<< " P2C, " << p1c.size() << " P1C, " << plc.size() << " PLC" << endl;
+	cout << "hash,items,buckets_used,max_bucket,probes_per_item,ns_per_insert" << endl;
+	report<contextSet, OldSetHash>("contextSet_old", sets);
+	report<contextSet, hash<contextSet>>("contextSet", sets);
+	report<OldP2C, OldP2CHash>("P2C_old", oldP2C);
+	report<P2C, hash<P2C>>("P2C", p2c);
+	report<P1C, hash<P1C>>("P1C", p1c);
+	report<PLC, hash<PLC>>("PLC", plc);
+}
@@ -0,0 +1,42 @@
+/****************************************************************
+ * File: bench/randomgrammar.h
+ * Random grammars the benchmarks time the engines on
+ ****************************************************************/
+#ifndef _RANDOMGRAMMAR_
+#define _RANDOMGRAMMAR_
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../cyke.h"
+
+using namespace::std;
+
+// The terminals a, b, c and d, interned in that order
+inline vector<symbol> fourTerminals(){
+	vector<symbol> sigma;
+	for (unsigned int a = 0; a < 4; a++)
+		sigma.push_back(terminals.intern(string(1, 'a' + a)));
+	return sigma;
+}
+
+// Random grammar over nt nonterminals and the terminals of sigma, with a few unary
+// rules, compiled
+// Every terminal can be several nonterminals, so most matrix cells fill up
+inline CFG randomGrammar(unsigned int nt, unsigned int rules, const vector<symbol> &sigma, mt19937 &rng){
+	CFG G;
+	for (unsigned int i = 0; i < nt; i++)
+		G.nonterminals.intern(to_string(i));
+	for (unsigned int i = 0; i < nt * 2; i++)
+		G.vpl.push_back(PL(rng() % nt, sigma[rng() % sigma.size()]));
+	for (unsigned int i = 0; i < nt / 8; i++)
+		G.vp1.push_back(P1(rng() % nt, rng() % nt));
+	for (unsigned int i = 0; i < rules; i++)
+		G.vp2.push_back(P2(rng() % nt, rng() % nt, rng() % nt));
+	G.starts.emplace(0);
+	G.compiled = compile(G);
+	return G;
+}
+
+#endif
@@ -0,0 +1,265 @@
+/****************************************************************
+ * File: bench/suite.cpp
+ * Baseline timings of accepts() per engine, Hf and the whole
+ * learner, on the bundled grammars and on random grammars of a
+ * given size
+ ****************************************************************
+ * Build from the "Yoshinaka Dual cpp" directory:
+ *   g++ -std=c++11 -O2 -I. bench/suite.cpp binaryio.cpp cachefile.cpp
+ *       checkpoint.cpp cyke.cpp earley.cpp featuresets.cpp grammarfile.cpp
+ *       incidence.cpp learner.cpp membership.cpp prefixchart.cpp
+ *       symbols.cpp threadpool.cpp types.cpp valiant.cpp -o suite -lpthread
+ * Run:
+ *   suite [--reps n] [--warmup n] [--quick] [grammar ...]
+ * The grammars are cfg00e.txt cfg0e.txt cfg1e.txt cfg2e.txt if none
+ * are given.  Every row is the median of reps timed runs after
+ * warmup untimed ones (5 and 1 by default).  --quick sweeps less
+ * and makes reps 3 unless --reps is given.  A learner run on all of
+ * cfg2e.txt takes about a minute, so --quick leaves it out unless it
+ * is named.  The random
+ * grammars and strings come from a fixed seed, so two runs time the
+ * same work.
+ *   accepts        accepts() per engine with a history that has not
+ *                  seen the strings, over sentence length on each
+ *                  grammar (random strings over its terminals) and
+ *                  over rule count on random grammars
+ *   hypothesis_accepts
+ *                  accepts() on the CFG learned from each grammar's
+ *                  samples, over sentence length
+ *   Hf             Hf from scratch, with K and F as after the first
+ *                  samples samples, every cell answered from the
+ *                  oracle's history and an empty featureSets; the
+ *                  variant is -f and --closed
+ *   learner        the dual algorithm over the first samples
+ *                  samples, from an empty history and featureSets; an
+ *                  operation is a whole run
+ * Output is CSV:
+ *   bench,grammar,variant,param,value,reps,ns_per_op,ops_per_s,peak_rss_kb
+ * peak_rss_kb is the process's high water mark so far (getrusage),
+ * so it only grows down the rows.
+ ****************************************************************/
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+#include "../cyke.h"
+#include "../featuresets.h"
+#include "../learner.h"
+#include "randomgrammar.h"
+
+using namespace::std;
+
+unsigned int reps = 5, warmup = 1;
+
+// Peak resident set of the process so far in kB, 0 where getrusage is missing
+long peakRSS(){
+#ifdef _WIN32
+	return 0;
+#else
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	return usage.ru_maxrss;
+#endif
+}
+
+// Median ns per operation over the timed runs of op
+// op(run) does one run and returns how many operations it did.  Runs are numbered
+// from 0, the warmups first, so each run can be given its own input.
+template <class F>
+double measure(F op){
+	for (unsigned int r = 0; r < warmup; r++)
+		op(r);
+	vector<double> ns;
+	for (unsigned int r = 0; r < reps; r++){
+		auto t0 = chrono::steady_clock::now();
+		double ops = op(warmup + r);
+		ns.push_back(chrono::duration<double, nano>(chrono::steady_clock::now() - t0).count() / max(ops, 1.0));
+	}
+	sort(ns.begin(), ns.end());
+	return ns[ns.size() / 2];
+}
+
+void report(const string &bench, const string &grammar, const string &variant,
+	const string &param, unsigned int value, double ns)
+{
+	cout << bench << "," << grammar << "," << variant << "," << param << "," << value << ","
+		<< reps << "," << (long long)ns << "," << (ns > 0 ? 1e9 / ns : 0) << "," << peakRSS() << endl;
+}
+
+// One batch of random strings of length n over sigma for every run of measure()
+vector<vector<vector<symbol>>> randomBatches(unsigned int n, unsigned int batch,
+	const vector<symbol> &sigma, mt19937 &rng)
+{
+	vector<vector<vector<symbol>>> batches(warmup + reps, vector<vector<symbol>>(batch));
+	for (auto &b : batches)
+		for (auto &w : b)
+			for (unsigned int i = 0; i < n; i++)
+				w.push_back(sigma[rng() % sigma.size()]);
+	return batches;
+}
+
+// The terminals G's lexical rules use
+vector<symbol> alphabet(const CFG &G){
+	vector<symbol> sigma;
+	for (auto &r : G.vpl)
+		if (find(sigma.begin(), sigma.end(), r.rhs) == sigma.end())
+			sigma.push_back(r.rhs);
+	return sigma;
+}
+
+// Each batch of strings against G, in a history of its own so none is answered
+// from an earlier run
+double timeAccepts(const CFG &G, const vector<vector<vector<symbol>>> &batches){
+	return measure([&](unsigned int run){
+		History h;
+		for (auto &w : batches[run])
+			accepts(w, G, G.compiled, h);
+		return (double)batches[run].size();
+	});
+}
+
+const char* engineNames[] = { "CYK_MATRIX", "VALIANT", "EARLEY", "PREFIX" };
+const CYKEngine engines[] = { CYK_MATRIX, VALIANT, EARLEY, PREFIX };
+
+// Times every engine on the same batches, and returns which ones stayed under a
+// tenth of a second a query, so a sweep can leave the rest out of its next step
+vector<bool> timeEngines(const string &grammar, const CFG &G, const string &param, unsigned int value,
+	const vector<vector<vector<symbol>>> &batches, const vector<bool> &running)
+{
+	vector<bool> keep(running);
+	for (int e = 0; e < 4; e++){
+		if (!running[e])
+			continue;
+		engineG = engines[e];
+		double ns = timeAccepts(G, batches);
+		report("accepts", grammar, engineNames[e], param, value, ns);
+		keep[e] = ns < 1e8;
+	}
+	engineG = CYK_MATRIX;
+	return keep;
+}
+
+// F after the samples of c, made the way DualLearner::restore makes it
+contextSet featuresOf(const Checkpoint &c){
+	contextSet ConD, F;
+	for (size_t i = 0; i < c.D.size(); i++){
+		addCon(ConD, c.D[i]);
+		if (c.grew[i])
+			for (auto cx : ConD.set)
+				F.add(cx);
+	}
+	return F;
+}
+
+int main(int argc, char* argv[]){
+	bool quick = false, repsGiven = false;
+	vector<string> files;
+	for (int i = 1; i < argc; i++){
+		if (string(argv[i]) == "--reps" && i + 1 < argc){
+			reps = max(atoi(argv[++i]), 1);
+			repsGiven = true;
+		}
+		else if (string(argv[i]) == "--warmup" && i + 1 < argc)
+			warmup = max(atoi(argv[++i]), 0);
+		else if (string(argv[i]) == "--quick")
+			quick = true;
+		else
+			files.push_back(argv[i]);
+	}
+	if (quick && !repsGiven)
+		reps = 3;
+	if (files.empty()){
+		files = { "cfg00e.txt", "cfg0e.txt", "cfg1e.txt" };
+		if (!quick)
+			files.push_back("cfg2e.txt");
+	}
+	vector<unsigned int> lengths = quick ? vector<unsigned int>{ 4, 16 } : vector<unsigned int>{ 4, 8, 16, 32, 64 };
+	vector<unsigned int> ruleCounts = quick ? vector<unsigned int>{ 128, 512 } : vector<unsigned int>{ 128, 512, 2048, 8192 };
+	unsigned int batch = quick ? 16 : 64;
+	// -f and --closed of the learner runs: the default, and bigger sets kept down to
+	// the closed ones
+	vector<pair<int, bool>> variants = { { 1, false }, { 2, true } };
+	mt19937 rng(1);
+
+	// The learner reports every Lhat check, which is not wanted here
+	ostringstream quiet;
+	streambuf* out = cout.rdbuf();
+
+	cout << "bench,grammar,variant,param,value,reps,ns_per_op,ops_per_s,peak_rss_kb" << endl;
+	for (auto &file : files){
+		CFG target = extractCFG((char*)file.c_str());
+		vector<symbol> sigma = alphabet(target);
+
+		vector<bool> running(4, true);
+		for (auto n : lengths)
+			running = timeEngines(file, target, "n", n, randomBatches(n, batch, sigma, rng), running);
+
+		unordered_set<symbol> lexicon(sigma.begin(), sigma.end());
+		for (auto &v : variants){
+			string variant = "f" + to_string(v.first) + (v.second ? "_closed" : "");
+			// The hypothesis and the learner's state after each number of samples
+			cout.rdbuf(quiet.rdbuf());
+			DualLearner learner(target, v.first, v.second);
+			vector<Checkpoint> after;
+			for (auto &w : target.samples){
+				learner.learn(w);
+				after.push_back(learner.state());
+			}
+			cout.rdbuf(out);
+			for (auto n : lengths)
+				report("hypothesis_accepts", file, variant, "n", n,
+					timeAccepts(learner.hypothesis(), randomBatches(n, batch, sigma, rng)));
+
+			vector<unsigned int> counts;
+			for (unsigned int k = 1; k < after.size() && !quick; k *= 2)
+				counts.push_back(k);
+			if (!after.empty())
+				counts.push_back(after.size());
+			for (auto k : counts){
+				const Checkpoint &c = after[k - 1];
+				contextSet F = featuresOf(c);
+				vector<vector<symbol>> K;
+				for (auto &w : c.D)
+					addSub(K, w);
+				double ns = measure([&](unsigned int){
+					featureSets.clear();
+					Incidence I;
+					Hf(F, K, target, lexicon, v.first, v.second, I);
+					return 1.0;
+				});
+				report("Hf", file, variant, "samples", k, ns);
+			}
+			for (auto k : counts){
+				cout.rdbuf(quiet.rdbuf());
+				double ns = measure([&](unsigned int){
+					historyG.clear();
+					historyG.prefix.clear();
+					featureSets.clear();
+					quiet.str("");
+					DualLearner run(target, v.first, v.second);
+					for (unsigned int i = 0; i < k; i++)
+						run.learn(target.samples[i]);
+					return 1.0;
+				});
+				cout.rdbuf(out);
+				report("learner", file, variant, "samples", k, ns);
+			}
+		}
+	}
+
+	// Random grammars with 32 nonterminals over 4 terminals, 32 token sentences
+	vector<symbol> sigma = fourTerminals();
+	vector<bool> running(4, true);
+	for (auto rules : ruleCounts)
+		running = timeEngines("random", randomGrammar(32, rules, sigma, rng), "rules", rules,
+			randomBatches(32, batch, sigma, rng), running);
+}
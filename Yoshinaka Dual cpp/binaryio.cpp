@@ -0,0 +1,127 @@
+/****************************************************************
+ * File: binaryio.cpp
+ * Implements binaryio.h
+ ****************************************************************/
+#include <cstdio>
+#include <fstream>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "binaryio.h"
+
+void putNames(vector<char> &out, const SymbolTable &table){
+	vector<uint32_t> lengths;
+	string chars;
+	for (symbol s = 0; s < table.size(); s++){
+		lengths.push_back(table.name(s).size());
+		chars += table.name(s);
+	}
+	putArray(out, lengths);
+	put(out, chars.data(), chars.size());
+}
+
+void putStrings(vector<char> &out, const vector<vector<symbol>> &ws){
+	vector<uint32_t> lengths;
+	vector<symbol> tokens;
+	for (auto &w : ws){
+		lengths.push_back(w.size());
+		tokens.insert(tokens.end(), w.begin(), w.end());
+	}
+	putArray(out, lengths);
+	putArray(out, tokens);
+}
+
+bool replaceFile(const string &file, const vector<char> &bytes){
+	string temp = file + ".tmp";
+	ofstream output(temp.c_str(), ios::binary | ios::trunc);
+	output.write(bytes.data(), bytes.size());
+	output.close();
+	if (!output || rename(temp.c_str(), file.c_str()) != 0){
+		remove(temp.c_str());
+		return false;
+	}
+	return true;
+}
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const string &file)
+	: bytes(NULL), length(0) {
+	ifstream input(file.c_str(), ios::binary);
+	if (!input.is_open())
+		return;
+	copy.assign(istreambuf_iterator<char>(input), istreambuf_iterator<char>());
+	bytes = copy.data();
+	length = copy.size();
+}
+
+MappedFile::~MappedFile(){}
+
+#else
+
+MappedFile::MappedFile(const string &file)
+	: bytes(NULL), length(0) {
+	int fd = open(file.c_str(), O_RDONLY);
+	if (fd < 0)
+		return;
+	struct stat st;
+	if (fstat(fd, &st) == 0 && st.st_size > 0){
+		void* p = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+		if (p != MAP_FAILED){
+			bytes = (const char*)p;
+			length = st.st_size;
+		}
+	}
+	close(fd);	// the mapping stays valid
+}
+
+MappedFile::~MappedFile(){
+	if (bytes != NULL)
+		munmap((void*)bytes, length);
+}
+
+#endif
+
+void Cursor::getNames(SymbolTable &table, vector<symbol> &ids){
+	vector<uint32_t> lengths;
+	getArray(lengths);
+	table.reserve(table.size() + lengths.size());
+	for (uint32_t n : lengths){
+		if (!ok || (size_t)(end - at) < n){
+			ok = false;
+			return;
+		}
+		ids.push_back(table.intern(string(at, n)));
+		at += n;
+	}
+}
+
+void Cursor::getStrings(vector<vector<symbol>> &ws, const vector<symbol> &ids){
+	vector<uint32_t> lengths;
+	vector<symbol> tokens;
+	getArray(lengths);
+	getArray(tokens);
+	if (!ok)
+		return;
+	ws.resize(lengths.size());
+	size_t next = 0;
+	for (size_t i = 0; i < lengths.size(); next += lengths[i], i++){
+		if (tokens.size() - next < lengths[i]){
+			ok = false;
+			return;
+		}
+		ws[i].assign(tokens.begin() + next, tokens.begin() + next + lengths[i]);
+		for (auto &a : ws[i]){
+			if (a >= ids.size()){
+				ok = false;
+				return;
+			}
+			a = ids[a];
+		}
+	}
+}
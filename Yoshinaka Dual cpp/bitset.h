@@ -0,0 +1,99 @@
+#ifndef _BITSET_
+#define _BITSET_
+
+#include <cstdint>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// Bitsets whose width is only known at runtime (e.g. the number of nonterminals)
+// They are plain runs of 64 bit words so chart cells can sit side by side in one array
+
+typedef uint64_t word;
+
+// Number of words needed to hold n bits
+inline unsigned int bitWords(unsigned int n){
+	return (n + 63) / 64;
+}
+
+inline bool testBit(const word* b, unsigned int i){
+	return (b[i >> 6] >> (i & 63)) & 1;
+}
+
+inline void setBit(word* b, unsigned int i){
+	b[i >> 6] |= (word)1 << (i & 63);
+}
+
+inline void clearBit(word* b, unsigned int i){
+	b[i >> 6] &= ~((word)1 << (i & 63));
+}
+
+// Index of the lowest set bit of x (x must not be 0)
+inline unsigned int lowestBit(word x){
+#ifdef _MSC_VER
+	unsigned long i;
+	_BitScanForward64(&i, x);
+	return i;
+#else
+	return __builtin_ctzll(x);
+#endif
+}
+
+// Number of set bits in x
+inline unsigned int countBits(word x){
+#ifdef _MSC_VER
+	return (unsigned int)__popcnt64(x);
+#else
+	return __builtin_popcountll(x);
+#endif
+}
+
+// Number of set bits in b
+inline unsigned int countBits(const word* b, unsigned int words){
+	unsigned int count = 0;
+	for (unsigned int k = 0; k < words; k++)
+		count += countBits(b[k]);
+	return count;
+}
+
+// a |= b
+inline void orBits(word* a, const word* b, unsigned int words){
+	for (unsigned int k = 0; k < words; k++)
+		a[k] |= b[k];
+}
+
+// a &= b
+inline void andBits(word* a, const word* b, unsigned int words){
+	for (unsigned int k = 0; k < words; k++)
+		a[k] &= b[k];
+}
+
+// Is every bit of b set in a?
+inline bool containsBits(const word* a, const word* b, unsigned int words){
+	for (unsigned int k = 0; k < words; k++)
+		if (b[k] & ~a[k])
+			return false;
+	return true;
+}
+
+// Is a & b non-empty?
+inline bool intersects(const word* a, const word* b, unsigned int words){
+	for (unsigned int k = 0; k < words; k++)
+		if (a[k] & b[k])
+			return true;
+	return false;
+}
+
+// Calls f(i) for every set bit i, lowest first
+template <typename F>
+inline void forEachBit(const word* b, unsigned int words, F f){
+	for (unsigned int k = 0; k < words; k++){
+		word x = b[k];
+		while (x){
+			f(k * 64 + lowestBit(x));
+			x &= x - 1;
+		}
+	}
+}
+
+#endif
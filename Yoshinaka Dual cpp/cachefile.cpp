@@ -0,0 +1,215 @@
+/****************************************************************
+ * File: cachefile.cpp
+ * Implements cachefile.h
+ ****************************************************************/
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "cachefile.h"
+
+static const char MAGIC[8] = { 'I', 'I', 'L', 'C', 'A', 'C', 'H', '1' };
+static const size_t HEADER = sizeof(MAGIC) + sizeof(uint64_t);
+static const size_t FLUSH_BYTES = (size_t)1 << 16;
+
+uint64_t grammarHash(vector<string> rules){
+	sort(rules.begin(), rules.end());
+	uint64_t h = 14695981039346656037ULL;	// FNV-1a
+	for (const string &r : rules){
+		for (unsigned char c : r){
+			h ^= c;
+			h *= 1099511628211ULL;
+		}
+		h ^= 0xff;	// rule separator, never a byte of a name
+		h *= 1099511628211ULL;
+	}
+	return h;
+}
+
+static void put32(vector<char> &out, uint32_t x){
+	out.insert(out.end(), (const char*)&x, (const char*)&x + sizeof(x));
+}
+
+static uint32_t get32(const char* p){
+	uint32_t x;
+	memcpy(&x, p, sizeof(x));
+	return x;
+}
+
+CacheFile::CacheFile()
+	: fd(-1), records(0), end(0) {}
+
+CacheFile::~CacheFile(){
+	flush();
+#ifndef _WIN32
+	if (fd >= 0)
+		close(fd);
+#endif
+}
+
+#ifdef _WIN32
+
+// No mmap/flock here, so answers are only cached for the current run
+bool CacheFile::open(const string &, uint64_t, MembershipCache &){
+	return false;
+}
+
+bool CacheFile::openFile(const string &, uint64_t, MembershipCache &){
+	return false;
+}
+
+void CacheFile::flush(){
+	pending.clear();
+}
+
+#else
+
+bool CacheFile::open(const string &dir, uint64_t grammar, MembershipCache &cache){
+	char hex[17];
+	snprintf(hex, sizeof(hex), "%016llx", (unsigned long long)grammar);
+	mkdir(dir.c_str(), 0755);
+	return openFile(dir + "/" + hex + ".cache", grammar, cache);
+}
+
+bool CacheFile::openFile(const string &file, uint64_t grammar, MembershipCache &cache){
+	name = file;
+	fd = ::open(name.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+	if (fd < 0)
+		return false;
+	flock(fd, LOCK_EX);
+
+	struct stat st;
+	fstat(fd, &st);
+	size_t size = st.st_size;
+	if (size < HEADER){	// new (or torn) file: start it over
+		char header[HEADER];
+		memcpy(header, MAGIC, sizeof(MAGIC));
+		memcpy(header + sizeof(MAGIC), &grammar, sizeof(grammar));
+		if (ftruncate(fd, 0) != 0 || write(fd, header, HEADER) != (ssize_t)HEADER){
+			flock(fd, LOCK_UN);
+			close(fd);
+			fd = -1;
+			return false;
+		}
+		end = HEADER;
+		flock(fd, LOCK_UN);
+		return true;
+	}
+
+	const char* data = (const char*)mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+	if (data == MAP_FAILED || memcmp(data, MAGIC, sizeof(MAGIC)) != 0
+		|| memcmp(data + sizeof(MAGIC), &grammar, sizeof(grammar)) != 0){
+		if (data != MAP_FAILED)
+			munmap((void*)data, size);
+		flock(fd, LOCK_UN);
+		close(fd);
+		fd = -1;
+		return false;
+	}
+
+	size_t at = HEADER;
+	vector<symbol> w;
+	while (at + 9 <= size){
+		uint32_t length = get32(data + at);
+		if (length < 9 || at + length > size)
+			break;
+		const char* p = data + at + 4;
+		const char* end = data + at + length;
+		bool answer = *p++ != 0;
+		uint32_t count = get32(p);
+		p += 4;
+		w.clear();
+		uint32_t k;
+		for (k = 0; k < count && p + 4 <= end; k++){
+			uint32_t n = get32(p);
+			p += 4;
+			if (p + n > end)
+				break;
+			w.push_back(terminals.intern(string(p, n)));
+			p += n;
+		}
+		if (k != count || p != end)
+			break;
+		cache.add(w, answer);
+		records++;
+		at += length;
+	}
+	munmap((void*)data, size);
+	if (at < size && ftruncate(fd, at) != 0){	// drop a partly written record
+		flock(fd, LOCK_UN);
+		close(fd);
+		fd = -1;
+		return false;
+	}
+	end = at;
+	flock(fd, LOCK_UN);
+	return true;
+}
+
+// Offset just past the last whole record, following the size of each record others
+// appended since from
+static size_t wholeRecords(int fd, size_t from, size_t size){
+	size_t at = from;
+	char length[4];
+	while (at + 9 <= size && pread(fd, length, sizeof(length), at) == (ssize_t)sizeof(length)){
+		uint32_t n = get32(length);
+		if (n < 9 || at + n > size)
+			break;
+		at += n;
+	}
+	return at;
+}
+
+void CacheFile::flush(){
+	if (fd < 0 || pending.empty()){
+		pending.clear();
+		return;
+	}
+	flock(fd, LOCK_EX);
+	struct stat st;
+	bool ok = fstat(fd, &st) == 0 && (size_t)st.st_size >= end;
+	size_t at = ok ? wholeRecords(fd, end, st.st_size) : end;
+	if (ok && (size_t)st.st_size != at)	// a writer stopped partway through a record
+		ok = ftruncate(fd, at) == 0;
+	size_t done = 0;
+	while (ok && done < pending.size()){
+		ssize_t n = write(fd, pending.data() + done, pending.size() - done);
+		if (n <= 0)
+			break;
+		done += n;
+	}
+	if (done == pending.size())
+		end = at + done;
+	else if (done > 0)	// cut the partial record off; if that fails too, the next flush does
+		ok = ftruncate(fd, at) == 0;
+	flock(fd, LOCK_UN);
+	pending.clear();
+}
+
+#endif
+
+void CacheFile::add(const vector<symbol> &w, bool answer){
+	if (fd < 0)
+		return;
+	size_t start = pending.size();
+	put32(pending, 0);	// size, filled in below
+	pending.push_back(answer ? 1 : 0);
+	put32(pending, w.size());
+	for (symbol s : w){
+		const string &t = terminals.name(s);
+		put32(pending, t.size());
+		pending.insert(pending.end(), t.begin(), t.end());
+	}
+	uint32_t length = pending.size() - start;
+	memcpy(&pending[start], &length, sizeof(length));
+	if (pending.size() >= FLUSH_BYTES)
+		flush();
+}
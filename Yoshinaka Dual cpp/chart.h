@@ -0,0 +1,85 @@
+/****************************************************************
+ * File: chart.h
+ * Flat CYK charts that are reused from one sentence to the next
+ ****************************************************************/
+#ifndef _CHART_
+#define _CHART_
+
+#include <algorithm>
+#include <vector>
+
+#include "bitset.h"
+
+using namespace::std;
+
+// Numbers the spans (i, j), 0 <= i < j <= n, of a CYK chart diagonal-major:
+// all spans of width 1 first, then width 2, and so on.  A split point of a span
+// reads two narrower spans, so the cells it needs sit in a few dense runs.
+class ChartLayout{
+public:
+	ChartLayout() : n(0) { widthStart.assign(2, 0); }
+	unsigned int slot(unsigned int i, unsigned int j) const { return widthStart[j - i] + i; }
+	unsigned int slots() const { return widthStart[n + 1]; }
+	unsigned int length() const { return n; }
+protected:
+	// Lays the chart out for a sentence of length n (only ever grows widthStart)
+	void layout(unsigned int length){
+		n = length;
+		if (widthStart.size() < n + 2)
+			widthStart.resize(n + 2);
+		widthStart[1] = 0;
+		for (unsigned int width = 1; width <= n; width++)
+			widthStart[width + 1] = widthStart[width] + n + 1 - width;
+	}
+	unsigned int n;
+	vector<unsigned int> widthStart;	// slot of span (0, width)
+};
+
+// A chart whose cells are containers (vectors of nonterminals, feature sets, ...)
+// Cells are cleared rather than freed between sentences, so they keep their capacity
+// and a chart that has seen its longest sentence makes no more allocations
+template <typename Cell>
+class ListChart : public ChartLayout{
+public:
+	void reset(unsigned int length){
+		layout(length);
+		if (cells.size() < slots())
+			cells.resize(slots());
+		for (unsigned int s = 0; s < slots(); s++)
+			cells[s].clear();
+	}
+	Cell &cell(unsigned int i, unsigned int j){ return cells[slot(i, j)]; }
+private:
+	vector<Cell> cells;
+};
+
+// A chart whose cells are bitsets over nonterminals, all in one array of words
+// Next to each cell it keeps the number of nonterminals in it and how many index
+// entries they have, which the engines use to pick a strategy per split point
+class BitChart : public ChartLayout{
+public:
+	BitChart() : W(0) {}
+	void reset(unsigned int length, unsigned int words){
+		layout(length);
+		W = words;
+		if (bits.size() < (size_t)slots() * W)
+			bits.resize((size_t)slots() * W);
+		if (counts.size() < slots()){
+			counts.resize(slots());
+			fans.resize(slots());
+		}
+		fill(bits.begin(), bits.begin() + (size_t)slots() * W, 0);
+		fill(counts.begin(), counts.begin() + slots(), 0);
+		fill(fans.begin(), fans.begin() + slots(), 0);
+	}
+	word* cell(unsigned int i, unsigned int j){ return &bits[(size_t)slot(i, j) * W]; }
+	unsigned int &count(unsigned int i, unsigned int j){ return counts[slot(i, j)]; }
+	unsigned int &fan(unsigned int i, unsigned int j){ return fans[slot(i, j)]; }
+private:
+	unsigned int W;			// words per cell
+	vector<word> bits;
+	vector<unsigned int> counts;	// nonterminals in each cell
+	vector<unsigned int> fans;	// index entries of the nonterminals in each cell
+};
+
+#endif
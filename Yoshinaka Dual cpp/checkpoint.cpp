@@ -0,0 +1,154 @@
+/****************************************************************
+ * File: checkpoint.cpp
+ * Implements checkpoint.h
+ ****************************************************************/
+#include "binaryio.h"
+#include "checkpoint.h"
+
+static const char MAGIC[8] = { 'Y', 'D', 'L', 'S', 'T', 'A', 'T', 'E' };
+static const uint32_t VERSION = 2;	// bump when the layout changes
+
+// Contexts as the strings of their left sides, then of their right sides
+static void putContexts(vector<char> &out, const vector<context> &cs){
+	vector<vector<symbol>> lhs, rhs;
+	for (auto &c : cs){
+		lhs.push_back(c.lhs);
+		rhs.push_back(c.rhs);
+	}
+	putStrings(out, lhs);
+	putStrings(out, rhs);
+}
+
+static void getContexts(Cursor &in, vector<context> &cs, const vector<symbol> &ids){
+	vector<vector<symbol>> lhs, rhs;
+	in.getStrings(lhs, ids);
+	in.getStrings(rhs, ids);
+	if (lhs.size() != rhs.size()){
+		in.ok = false;
+		return;
+	}
+	cs.clear();
+	for (size_t i = 0; i < lhs.size(); i++)
+		cs.push_back(context(lhs[i], rhs[i]));
+}
+
+// The rules as flat arrays of ids, terminals given as they are in this run
+static void putRules(vector<char> &out, const CFGC &H){
+	vector<uint32_t> p0c, p1c, p2c, plc;
+	for (auto &r : H.sp0c.set)
+		p0c.push_back(r.lhs);
+	for (auto &r : H.sp1c.set){
+		p1c.push_back(r.lhs);
+		p1c.push_back(r.rhs);
+	}
+	for (auto &r : H.sp2c.set){
+		p2c.push_back(r.lhs);
+		p2c.push_back(r.rhs1);
+		p2c.push_back(r.rhs2);
+	}
+	for (auto &r : H.splc.set){
+		plc.push_back(r.lhs);
+		plc.push_back(r.rhs);
+	}
+	putArray(out, p0c);
+	putArray(out, p1c);
+	putArray(out, p2c);
+	putArray(out, plc);
+}
+
+// Every set id must be below sets, every terminal one of ids
+static void getRules(Cursor &in, CFGC &H, size_t sets, const vector<symbol> &ids){
+	vector<uint32_t> p0c, p1c, p2c, plc;
+	in.getArray(p0c);
+	in.getArray(p1c);
+	in.getArray(p2c);
+	in.getArray(plc);
+	if (!in.ok || p1c.size() % 2 != 0 || p2c.size() % 3 != 0 || plc.size() % 2 != 0){
+		in.ok = false;
+		return;
+	}
+	for (size_t i = 0; i < plc.size(); i += 2){
+		if (plc[i + 1] >= ids.size()){
+			in.ok = false;
+			return;
+		}
+		plc[i + 1] = ids[plc[i + 1]];
+	}
+	for (auto v : { &p0c, &p1c, &p2c })
+		for (auto id : *v)
+			if (id >= sets){
+				in.ok = false;
+				return;
+			}
+	for (size_t i = 0; i < plc.size(); i += 2)
+		if (plc[i] >= sets){
+			in.ok = false;
+			return;
+		}
+	for (auto id : p0c)
+		H.sp0c.set.emplace(P0C(id));
+	for (size_t i = 0; i < p1c.size(); i += 2)
+		H.sp1c.set.emplace(P1C(p1c[i], p1c[i + 1]));
+	for (size_t i = 0; i < p2c.size(); i += 3)
+		H.sp2c.set.emplace(P2C(p2c[i], p2c[i + 1], p2c[i + 2]));
+	for (size_t i = 0; i < plc.size(); i += 2)
+		H.splc.set.emplace(PLC(plc[i], plc[i + 1]));
+}
+
+bool writeCheckpoint(const string &file, const Checkpoint &c){
+	vector<char> out;
+	put(out, MAGIC, sizeof(MAGIC));
+	put32(out, VERSION);
+	put64(out, c.grammar);
+	put32(out, c.f);
+	put32(out, c.closed);
+	put64(out, c.targetSamples);
+	put64(out, c.streamLines);
+	putNames(out, terminals);
+	putStrings(out, c.D);
+	putArray(out, c.grew);
+	putContexts(out, c.contexts);
+
+	vector<uint32_t> sizes;
+	vector<context> all;
+	for (auto &s : c.sets){
+		sizes.push_back(s.size());
+		all.insert(all.end(), s.begin(), s.end());
+	}
+	putArray(out, sizes);
+	putContexts(out, all);
+	putRules(out, c.Hhat);
+	return replaceFile(file, out);
+}
+
+bool readCheckpoint(const string &file, Checkpoint &c){
+	MappedFile map(file);
+	Cursor in(map);
+	char magic[sizeof(MAGIC)];
+	in.take(magic, sizeof(magic));
+	if (!in.ok || memcmp(magic, MAGIC, sizeof(MAGIC)) != 0 || in.get32() != VERSION)
+		return false;
+	c.grammar = in.get64();
+	c.f = in.get32();
+	c.closed = in.get32() != 0;
+	c.targetSamples = in.get64();
+	c.streamLines = in.get64();
+	vector<symbol> ids;
+	in.getNames(terminals, ids);
+	in.getStrings(c.D, ids);
+	in.getArray(c.grew);
+	getContexts(in, c.contexts, ids);
+
+	vector<uint32_t> sizes;
+	vector<context> all;
+	in.getArray(sizes);
+	getContexts(in, all, ids);
+	size_t next = 0;
+	for (size_t i = 0; in.ok && i < sizes.size(); next += sizes[i], i++){
+		if (all.size() - next < sizes[i])
+			return false;
+		c.sets.push_back(vector<context>(all.begin() + next, all.begin() + next + sizes[i]));
+	}
+	getRules(in, c.Hhat, c.sets.size(), ids);
+	return in.ok && c.grew.size() == c.D.size();
+}
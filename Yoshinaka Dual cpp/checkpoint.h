@@ -0,0 +1,52 @@
+/****************************************************************
+ * File: checkpoint.h
+ * The learner's state saved to a file, so a stopped run can be
+ * resumed
+ ****************************************************************/
+#ifndef _CHECKPOINT_
+#define _CHECKPOINT_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "types.h"
+
+using namespace::std;
+
+// Everything fFCP needs to go on after the samples it has learned, and how far it got
+// through its input.  The oracle's answers are not saved with it but appended as they
+// are made to a CacheFile log (the --cache file, or file.answers next to the
+// checkpoint), so a checkpoint never writes an answer twice.
+//
+// ConD, SubD, K and F are not saved but made again from D, adding ConD to F after the
+// samples in grew.  They are hash sets, so only the same steps give them the same
+// iteration order, which decides the order new contexts are numbered in.  The contexts
+// already numbered, every interned feature set and Hhat are saved as they are.
+//
+// The file starts with a magic and a format version, and is laid out like a binary
+// grammar (see binaryio.h).  Every terminal's name is saved, so a run that meets its
+// terminals in another order can still read it.
+struct Checkpoint{
+	Checkpoint()
+		: grammar(0), f(0), closed(false), targetSamples(0), streamLines(0) {}
+	uint64_t grammar;		// hashCFG() of the target
+	int f;
+	bool closed;
+	uint64_t targetSamples;		// samples of the target's own learned
+	uint64_t streamLines;		// lines of the stream read, SampleReader::lineCount()
+	vector<vector<symbol>> D;
+	vector<char> grew;		// whether F took in ConD after each sample of D
+	vector<context> contexts;	// the Incidence's contexts, in index order
+	vector<vector<context>> sets;	// featureSets, in id order
+	CFGC Hhat;
+};
+
+// Saves c to file, replacing it with a rename so a run killed while saving leaves the
+// last checkpoint whole.  The answer log should be flushed first.
+bool writeCheckpoint(const string &file, const Checkpoint &c);
+// Loads a file written by writeCheckpoint into c
+// Returns false if the file can't be read or has another format version
+bool readCheckpoint(const string &file, Checkpoint &c);
+
+#endif
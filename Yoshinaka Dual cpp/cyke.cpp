@@ -5,34 +5,55 @@
 ****************************************************************/
 #include <iomanip>
 #include <iostream>
-#include <iomanip>
-#include <queue>
+#include <memory>
 
 #include "cyke.h"
 
 History historyG;
+CYKEngine engineG = CYK_MATRIX;
+thread_local BitChart chartG;
+
+// The EARLEY and VALIANT recognizers of the last grammar this thread parsed with,
+// built again only when it parses with another one
+struct Recognizers{
+	const CFG* G = NULL;
+	const CompiledGrammar* C = NULL;
+	unsigned long long version = 0;
+	unique_ptr<EarleyRecognizer> earley;
+	unique_ptr<ValiantRecognizer> valiant;
+	void use(const CFG &G, const CompiledGrammar &C){
+		if (this->G != &G || this->C != &C || version != C.version){
+			earley.reset();
+			valiant.reset();
+			this->G = &G;
+			this->C = &C;
+			version = C.version;
+		}
+	}
+};
+static thread_local Recognizers recognizersG;
 
-// Prints the CFG Matrix for debugging purposes
-void printMatrix(unordered_set<string>** matrix, unsigned int size){
+// Prints the CFG Matrix for debugging purposes ([i][j] is the chart span (i, j + 1))
+void printMatrix(BitChart &chart, unsigned int W){
+	unsigned int size = chart.length();
 	for (unsigned int j = 0; j < size; j++){
 		for (unsigned int i = 0; i < size; i++){
 			cout << setw(2) << i << "," << setw(2) << j << ":";
 			cout << setw(5);
 			string temp = "";
-			for (auto s : matrix[i][j])
-				temp += s;
+			if (i <= j)
+				forEachBit(chart.cell(i, j + 1), W, [&](unsigned int s){ temp += to_string(s); });
 			cout << temp;
 		}
 		cout << endl;
 	}
 }
 
-// Prints chain map
-void printChains(unordered_map<string, unordered_set<string>> chains){
-	for (auto x : chains){
-		cout << x.first << ":";
-		for (auto C : x.second)
-			cout << " " << C;
+// Prints the chains of a compiled grammar
+void printChains(const CompiledGrammar &C){
+	for (symbol x = 0; x < C.nonterminals; x++){
+		cout << x << ":";
+		forEachBit(C.chain(x), C.ntWords, [&](unsigned int A){ cout << " " << A; });
 		cout << endl;
 	}
 }
@@ -41,194 +62,360 @@ void printChains(unordered_map<string, unordered_set<string>> chains){
 /* CFG CYK algorithm                                          */
 ////////////////////////////////////////////////////////////////
 
-unordered_map<string, bool> buildNullable(const CFG &G){
-	unordered_map<string, bool> nullable;
-	unordered_map<string, unordered_set<string>> occurs1;
-	struct pair{
-		string lhs;
-		string rhs;
-	};
-	struct vpair{
-		vector<pair> vec;
+// {A | A =>* λ}, by a worklist over the rules
+// Each rule counts its right hand side nonterminals not yet known to be nullable, and
+// its left hand side becomes nullable when the count reaches 0
+static void buildNullable(const CFG &G, CompiledGrammar &C){
+	C.nullable.assign(C.ntWords, 0);
+	vector<unsigned int> lhs, pending;		// rule -> its lhs, its count
+	vector<vector<unsigned int>> occurs(C.nonterminals);	// B -> rules with B on the right, once per B
+	vector<symbol> todo;
+
+	auto nullable = [&](symbol A){
+		if (!testBit(C.nullable.data(), A)){
+			setBit(C.nullable.data(), A);
+			todo.push_back(A);
+		}
 	};
-	unordered_map<string, vpair> occurs2;
-	queue<string> todo;
+	for (auto &p0 : G.vp0)	// empty rules
+		nullable(p0.lhs);
+	for (auto &p1 : G.vp1){	// unary rules
+		occurs[p1.rhs].push_back(lhs.size());
+		lhs.push_back(p1.lhs);
+		pending.push_back(1);
+	}
+	for (auto &p2 : G.vp2){	// binary rules
+		occurs[p2.rhs1].push_back(lhs.size());
+		occurs[p2.rhs2].push_back(lhs.size());
+		lhs.push_back(p2.lhs);
+		pending.push_back(2);
+	}
+	// Lexical rules never derive λ
+
+	while (!todo.empty()){
+		symbol B = todo.back();
+		todo.pop_back();
+		for (auto r : occurs[B])
+			if (--pending[r] == 0)
+				nullable(lhs[r]);
+	}
+}
 
-	for (unsigned int i = 0; i < G.vp1.size(); i++){	// unary rules
-		nullable.emplace(G.vp1[i].lhs, false);
-		occurs1[G.vp1[i].rhs].emplace(G.vp1[i].lhs);
+// Row x of chains is {C | C =>* x}: C -> x, or C -> x B or C -> B x with B nullable,
+// closed under transitivity by Warshall's algorithm on the bit matrix
+static void buildChains(const CFG &G, CompiledGrammar &C){
+	unsigned int W = C.ntWords;
+	C.chains.assign((size_t)C.nonterminals * W, 0);
+	auto row = [&](symbol x){ return &C.chains[(size_t)x * W]; };
+	for (symbol x = 0; x < C.nonterminals; x++)
+		setBit(row(x), x);
+	for (auto &p1 : G.vp1)
+		setBit(row(p1.rhs), p1.lhs);
+	for (auto &p2 : G.vp2){
+		if (testBit(C.nullable.data(), p2.rhs1))
+			setBit(row(p2.rhs2), p2.lhs);
+		if (testBit(C.nullable.data(), p2.rhs2))
+			setBit(row(p2.rhs1), p2.lhs);
 	}
-	for (unsigned int i = 0; i < G.vp2.size(); i++){	// binary rules
-		nullable.emplace(G.vp2[i].lhs, false);
-		pair AC, AB;
-		AC.lhs = G.vp2[i].lhs;
-		AC.rhs = G.vp2[i].rhs2;
-		occurs2[G.vp2[i].rhs1].vec.push_back(AC);
-		AB.lhs = G.vp2[i].lhs;
-		AB.rhs = G.vp2[i].rhs1;
-		occurs2[G.vp2[i].rhs2].vec.push_back(AB);
+	// k =>* x and C =>* k give C =>* x; k has to be the outer loop
+	for (symbol k = 0; k < C.nonterminals; k++)
+		for (symbol x = 0; x < C.nonterminals; x++)
+			if (x != k && testBit(row(x), k))
+				orBits(row(x), row(k), W);
+}
+
+// Makes terminals with the same {A} share one copy of it
+// A lexicon of many words in a few classes then keeps one set per class
+static void shareLexicalSets(GrammarTables &tables, unsigned int W){
+	size_t bytes = W * sizeof(word);
+	unordered_map<string, unsigned int> offsets;
+	vector<word> sets;
+	for (auto &offset : tables.lexicon){
+		if (offset == GrammarIndex::NONE)
+			continue;
+		const word* As = &tables.lexicalSets[offset];
+		auto it = offsets.emplace(string((const char*)As, bytes), sets.size()).first;
+		if (it->second == sets.size())	// a set not seen before
+			sets.insert(sets.end(), As, As + W);
+		offset = it->second;
 	}
-	for (unsigned int i = 0; i < G.vpl.size(); i++)		// lexical rules
-		nullable.emplace(G.vpl[i].lhs, false);
-	for (unsigned int i = 0; i < G.vp0.size(); i++){	// empty rules
-		nullable.emplace(G.vp0[i].lhs, true);
-		todo.push(G.vp0[i].lhs);
+	tables.lexicalSets.swap(sets);
+}
+
+// Lays out (B, C) -> offset as GrammarIndex::pairs, with at least twice as many slots
+static vector<PairSlot> pairTable(const unordered_map<uint64_t, unsigned int> &pairs){
+	size_t size = 0;
+	if (pairs.size() > 0)
+		for (size = 2; size < 2 * pairs.size(); size *= 2);
+	vector<PairSlot> table(size, PairSlot(EMPTY_PAIR, 0));
+	for (auto &p : pairs){
+		size_t i = pairSlot(p.first, size - 1);
+		while (table[i].key != EMPTY_PAIR)
+			i = (i + 1) & (size - 1);
+		table[i] = PairSlot(p.first, p.second);
 	}
-	// todo loop
-	while (todo.empty() == false){
-		string B = todo.front();
-		todo.pop();
-		// Using an iterator, go through all elements in occurs1[B]
-		for (auto& it : occurs1[B]){
-			if (nullable[it] == false){
-				nullable[it] = true;
-				todo.push(it);
-			}
-		}
-		// Using an iterator, go through all elements in occurs2[B]
-		for (auto& it : occurs2[B].vec){
-			if (nullable[it.lhs] == true && nullable[it.lhs] == false){
-				nullable[it.lhs] = true;
-				todo.push(it.lhs);
-			}
+	return table;
+}
+
+// Builds the lexicon and binary rule lookup tables for a CFG
+// The sets are closed under chains, so the matrix never has to apply chains itself
+static void buildIndex(const CFG &G, CompiledGrammar &C){
+	GrammarIndex &index = C.index;
+	index.nonterminals = C.nonterminals;
+	unsigned int W = index.ntWords = C.ntWords;
+	shared_ptr<GrammarTables> tables = make_shared<GrammarTables>();
+	GrammarTables &t = *tables;
+
+	for (auto& pl : G.vpl){	// a terminal is derived by everything that derives its lhs
+		if (pl.rhs >= t.lexicon.size())
+			t.lexicon.resize(pl.rhs + 1, GrammarIndex::NONE);
+		if (t.lexicon[pl.rhs] == GrammarIndex::NONE){	// First rule with this terminal
+			t.lexicon[pl.rhs] = t.lexicalSets.size();
+			t.lexicalSets.resize(t.lexicon[pl.rhs] + W, 0);
 		}
+		orBits(&t.lexicalSets[t.lexicon[pl.rhs]], C.chain(pl.lhs), W);
 	}
+	shareLexicalSets(t, W);
 
-	return nullable;
+	unordered_map<uint64_t, unsigned int> pairs;
+	vector<vector<BinaryEntry>> byLeft(index.nonterminals);
+	for (auto& p2 : G.vp2){
+		uint64_t key = (uint64_t)p2.rhs1 << 32 | p2.rhs2;
+		auto it = pairs.find(key);
+		if (it == pairs.end()){	// First rule with this (B, C)
+			unsigned int offset = t.parentSets.size();
+			t.parentSets.resize(offset + W, 0);
+			it = pairs.emplace(key, offset).first;
+			byLeft[p2.rhs1].push_back(BinaryEntry(p2.rhs2, offset));
+		}
+		orBits(&t.parentSets[it->second], C.chain(p2.lhs), W);	// Every C =>* A
+	}
+	t.pairs = pairTable(pairs);
+	for (auto &entries : byLeft){
+		t.firstEntry.push_back(t.entries.size());
+		t.entries.insert(t.entries.end(), entries.begin(), entries.end());
+	}
+	t.firstEntry.push_back(t.entries.size());
+	index.use(tables);
 }
 
-// chains maps each symbol x to {C| C =>* x} (key:string x, value:set of strings C1, C2, ...)
-unordered_map<string, unordered_set<string>> buildChains(const CFG &G, unordered_map<string, bool> nullable){
-	unordered_map<string, unordered_set<string>> chains;
-
-	// Emplace is set insertion (unique elements only)
-	// Also references existing element or creates new one automatically
-	// Initialize with non-terminals
-	for (auto& it : nullable)
-		chains[it.first].emplace(it.first);
-	// Lexical Rules
-	for (auto& pl : G.vpl)
-		chains[pl.rhs].emplace(pl.lhs);	
-	// Unary rules
-	for (auto& p1 : G.vp1)
-		chains[p1.rhs].emplace(p1.lhs);
-	// Binary rules
-	for (auto& p2 : G.vp2){
-		if (nullable[p2.rhs1])
-			chains[p2.rhs2].emplace(p2.lhs);
-		if (nullable[p2.rhs2])
-			chains[p2.rhs1].emplace(p2.lhs);
+CompiledGrammar compile(const CFG &G){
+	CompiledGrammar C;
+	C.nonterminals = G.nonterminals.size();
+	auto see = [&](symbol A){ C.nonterminals = max(C.nonterminals, A + 1); };
+	for (auto &p0 : G.vp0)
+		see(p0.lhs);
+	for (auto &p1 : G.vp1){
+		see(p1.lhs);
+		see(p1.rhs);
 	}
-	// Compute transitive closure
-	for (auto& i : chains)	// i,j,k are iterators to chains elements
-		for (auto& j : chains)
-			for (auto& k : chains)
-				if (i.second.find(k.first) != i.second.end()	// k is in chains[i]
-					&& k.second.find(j.first) != k.second.end())	// j is in chains[k]
-					i.second.emplace(j.first);	// add j key to i set
-
-	return chains;
+	for (auto &p2 : G.vp2){
+		see(p2.lhs);
+		see(p2.rhs1);
+		see(p2.rhs2);
+	}
+	for (auto &pl : G.vpl)
+		see(pl.lhs);
+	for (auto S : G.starts)
+		see(S);
+	C.ntWords = bitWords(C.nonterminals);
+
+	buildNullable(G, C);
+	buildChains(G, C);
+	buildIndex(G, C);
+	return C;
 }
 
-void buildMatrix(const vector<string> &w, const CFG &G,
-	unordered_map<string, unordered_set<string>> chains,
-	unordered_set<string>** matrix, const unsigned int n)
-{
-	// Lexical initialization
-	for (unsigned int i = 0; i < n; i++)
-		for (auto C : chains[w[i]])	// For every {C| C =>* w[i]}
-			matrix[i][i].emplace(C);	// Add C to the set at [i][i]
-
-	// printMatrix(matrix, n);
-
-	for (int j = 1; j < n; j++)
-		for (int i = j; i >= 0; i--)
-			for (int h = i; h < j; h++)
-				for (auto p2 : G.vp2) // For every P2 in G (A -> yz)
-					if (matrix[i][h].find(p2.rhs1) != matrix[i][h].end()
-						&& matrix[h + 1][j].find(p2.rhs2) != matrix[h + 1][j].end())
-						for (auto C : chains[p2.lhs]) // Add every C =>* A from chains
-							matrix[i][j].emplace(C);
-
-	// printMatrix(matrix, n);
+const unsigned int GrammarIndex::NONE;
+
+void GrammarIndex::use(const shared_ptr<const GrammarTables> &tables){
+	lexicon = tables->lexicon;
+	lexicalSets = tables->lexicalSets;
+	pairs = tables->pairs;
+	firstEntry = tables->firstEntry;
+	entries = tables->entries;
+	parentSets = tables->parentSets;
+	storage = tables;
 }
 
-// Called with calculated chains/nullable maps
-bool accepts(const vector<string> &w, const CFG &G, const unordered_map<string, unordered_set<string>> &chains, History &history){
-	// If this call has been made before, return check (previous result)
-	int check = history.checkHistory(w);
-	if (check == 0)
-		return false;
-	else if (check == 1)
-		return true;
+// {A | A =>* a}, or NULL if nothing derives a
+const word* GrammarIndex::lexical(symbol a) const{
+	if (a >= lexicon.size() || lexicon[a] == NONE)
+		return NULL;
+	return &lexicalSets[lexicon[a]];
+}
 
-	bool success = false;
+// {A | A =>* B C}, or NULL if no rule has these children
+const word* GrammarIndex::parents(symbol B, symbol C) const{
+	if (pairs.size() == 0)
+		return NULL;
+	uint64_t key = (uint64_t)B << 32 | C;
+	size_t mask = pairs.size() - 1;
+	for (size_t i = pairSlot(key, mask);; i = (i + 1) & mask){
+		if (pairs[i].key == key)
+			return &parentSets[pairs[i].parents];
+		if (pairs[i].key == EMPTY_PAIR)
+			return NULL;
+	}
+}
 
-	// Matrix is dynamically allocated 2D array of sets of strings
+// A split point walks the (C, {A}) entries of each B in the left cell and adds {A}
+// when C is in the right cell.  If the two cells are small compared to the number of
+// those entries, it looks up every (B, C) pair in the pair index instead.
+// Span (i, j) of the chart holds {A | A =>* w[i..j-1]}
+void buildMatrix(const vector<symbol> &w, const GrammarIndex &index, BitChart &chart){
 	unsigned int n = w.size();
-	if (n == 0) return false;
-	unordered_set<string>** matrix = new unordered_set<string>*[n];
-	for (unsigned int i = 0; i < n; ++i)
-		matrix[i] = new unordered_set<string>[n];
-
-	// printChains(chains);
-	// Do all the CYK magic to the matrix
-	buildMatrix(w, G, chains, matrix, n);
+	unsigned int W = index.ntWords;
+	chart.reset(n, W);	// Reuses the storage of earlier sentences
+	auto finish = [&](unsigned int i, unsigned int j){
+		unsigned int &size = chart.count(i, j), &fan = chart.fan(i, j);
+		forEachBit(chart.cell(i, j), W, [&](unsigned int B){
+			size++;
+			fan += index.byLeft(B).size();
+		});
+	};
 
-	// printMatrix(matrix, n);
+	// Lexical initialization
+	for (unsigned int i = 0; i < n; i++){
+		const word* Cs = index.lexical(w[i]);
+		if (Cs != NULL)	// For every {C| C =>* w[i]}
+			orBits(chart.cell(i, i + 1), Cs, W);	// Add C to the set at (i, i + 1)
+		finish(i, i + 1);
+	}
 
-	// Is the top left cell the start symbol?
-	
-	for (auto s : G.starts){	// Test for each start symbol
-		if (matrix[0][n-1].find(s) != matrix[0][n-1].end()){
-			success = true;
-			break;
+	// printMatrix(chart, W);
+
+	for (unsigned int width = 2; width <= n; width++){
+		for (unsigned int i = 0; i + width <= n; i++){
+			unsigned int j = i + width;
+			word* cell = chart.cell(i, j);
+			for (unsigned int h = i + 1; h < j; h++){
+				unsigned int lsize = chart.count(i, h), rsize = chart.count(h, j);
+				if (lsize == 0 || rsize == 0)
+					continue;
+				const word* left = chart.cell(i, h);
+				const word* right = chart.cell(h, j);
+				if (lsize * rsize < chart.fan(i, h)){
+					forEachBit(left, W, [&](unsigned int B){
+						forEachBit(right, W, [&](unsigned int C){
+							const word* As = index.parents(B, C);
+							if (As)
+								orBits(cell, As, W);
+						});
+					});
+				}
+				else{
+					forEachBit(left, W, [&](unsigned int B){
+						for (const BinaryEntry &e : index.byLeft(B))
+							if (testBit(right, e.right))
+								orBits(cell, &index.parentSets[e.parents], W);
+					});
+				}
+			}
+			finish(i, j);
 		}
 	}
 
-	for (unsigned int i = 0; i < n; ++i)	// Delete the dynamically allocated array from memory
-		delete[] matrix[i];
-	delete[] matrix;
-
-	// add the string to the oracle's call history
-	// note that unordered maps only accept standard types
-	// to account for this, we take all elements of w and concatenate them into s
-	string s;
-	for (unsigned int i = 0; i < w.size(); i++)
-		s += w[i];
-	history.add(s, success);
+	// printMatrix(chart, W);
+}
 
-	return success;
+// True if one of G's start symbols is in the top cell
+static bool hasStart(const word* top, const CFG &G, const GrammarIndex &index){
+	for (auto s : G.starts)	// Test for each start symbol
+		if (s < index.nonterminals && testBit(top, s))
+			return true;
+	return false;
 }
 
-// Called if no chains/nullable maps are pre-calculated
-bool accepts(const vector<string> &w, const CFG &G, History &history){
-	const auto chains = buildChains(G, buildNullable(G));
-	return accepts(w, G, chains, history);
+// Parses w with engineG, without looking at any history
+// Several threads can do this at once, except with PREFIX, as the trie is not shared
+static bool recognize(const vector<symbol> &w, const CFG &G, const CompiledGrammar &C, PrefixChart &prefix){
+	unsigned int n = w.size();
+	const GrammarIndex &index = C.index;
+
+	if (n == 0 || engineG == EARLEY){
+		recognizersG.use(G, C);
+		if (!recognizersG.earley)
+			recognizersG.earley.reset(new EarleyRecognizer(G, C));
+		return recognizersG.earley->recognize(w, G.starts);
+	}
+	else if (engineG == VALIANT){
+		recognizersG.use(G, C);
+		if (!recognizersG.valiant)
+			recognizersG.valiant.reset(new ValiantRecognizer(index));
+		vector<word> top;
+		recognizersG.valiant->parse(w, top);
+		return hasStart(top.data(), G, index);
+	}
+	else if (engineG == PREFIX)
+		return hasStart(prefix.parse(w, index), G, index);
+
+	// Do all the CYK magic to the chart
+	buildMatrix(w, index, chartG);
+
+	// Is the top left cell the start symbol?
+	return hasStart(chartG.cell(0, n), G, index);
 }
 
-////////////////////////////////////////////////////////////////
-/* Call History stuff                                         */
-////////////////////////////////////////////////////////////////
+bool accepts(const vector<symbol> &w, const CFG &G, const CompiledGrammar &C, History &history){
+	// If this call has been made before, return the previous result
+	// Otherwise answer is w's new entry in the history, filled in below
+	signed char &answer = history.lookup(w);
+	if (answer >= 0)
+		return answer == 1;
 
-// Returns -1 if w has not been called
-// If w has been called, it returns its value (true/false)
-int History::checkHistory(vector<string> w){
-	// string vectors have to be converted into a single, concatenated string
-	string s;
-	for (unsigned int i = 0; i < w.size(); i++)
-		s += w[i];
+	bool success = recognize(w, G, C, history.prefix);
 
+	// add the string to the oracle's call history
+	answer = success;
+	history.store.add(w, success);
 
-	unordered_map<string, bool>::const_iterator it = map.find(s);
-	if (it == map.end())
-		return -1;
-	else
-		return it->second;
+	return success;
 }
 
-void History::add(string s, bool b){
-	map.emplace(s, b);
+vector<word> acceptsBatch(const vector<vector<symbol>> &ws, const CFG &G, const CompiledGrammar &C,
+	History &history, ThreadPool &pool)
+{
+	vector<word> result(bitWords(ws.size()), 0);
+	vector<size_t> jobs;		// first occurrence of each string the history doesn't know
+	vector<size_t> repeats;		// later occurrences of those strings
+	for (size_t i = 0; i < ws.size(); i++){
+		signed char &answer = history.lookup(ws[i]);
+		if (answer == 1)
+			setBit(result.data(), i);
+		else if (answer == -1){
+			answer = -2;	// queued, so a repeat of ws[i] is told apart from a new string
+			jobs.push_back(i);
+		}
+		else if (answer == -2)
+			repeats.push_back(i);
+	}
+
+	vector<char> answers(jobs.size());
+	if (engineG == PREFIX){
+		for (size_t j = 0; j < jobs.size(); j++)
+			answers[j] = recognize(ws[jobs[j]], G, C, history.prefix);
+	}
+	else{
+		pool.parallelFor(jobs.size(), [&](unsigned int, size_t j){
+			answers[j] = recognize(ws[jobs[j]], G, C, history.prefix);
+		});
+	}
+
+	for (size_t j = 0; j < jobs.size(); j++){
+		history.add(ws[jobs[j]], answers[j] != 0);
+		history.store.add(ws[jobs[j]], answers[j] != 0);
+		if (answers[j])
+			setBit(result.data(), jobs[j]);
+	}
+	for (size_t i : repeats){
+		int answer = history.find(ws[i]);
+		if (answer < 0)		// the history was emptied to stay under its limit
+			answer = accepts(ws[i], G, C, history);
+		if (answer == 1)
+			setBit(result.data(), i);
+	}
+	return result;
 }
 
 ////////////////////////////////////////////////////////////////
@@ -237,39 +424,37 @@ void History::add(string s, bool b){
 
 // Checks the input samples for a grammar to make sure they're accepted
 void checkSamples(const CFG &G){
-	auto chains = buildChains(G, buildNullable(G));
 	for (auto s : G.samples){
-		bool accepted = accepts(s, G, chains, historyG);
+		bool accepted = accepts(s, G, G.compiled, historyG);
 		if (accepted){
 			cout << "Accepted by target grammar:";
 			for (unsigned int j = 0; j < s.size(); j++)
-				cout << " " << s[j];
+				cout << " " << terminals.name(s[j]);
 			cout << endl;
 		}
 		else{
 			cout << "Rejected by target grammar:";
 			for (unsigned int j = 0; j < s.size(); j++)
-				cout << " " << s[j];
+				cout << " " << terminals.name(s[j]);
 			cout << endl;
 			exit(1);
 		}
 	}
 }
 
-void checkLearner(const CFG &G, History h, const vector<vector<string>> &samples){
-	auto chains = buildChains(G, buildNullable(G));
+void checkLearner(const CFG &G, History &h, const vector<vector<symbol>> &samples){
 	for (auto s : samples){
-		bool accepted = accepts(s, G, chains, h);
+		bool accepted = accepts(s, G, G.compiled, h);
 		if (accepted){
 			cout << "Accepted by learner grammar:";
 			for (unsigned int j = 0; j < s.size(); j++)
-				cout << " " << s[j];
+				cout << " " << terminals.name(s[j]);
 			cout << endl;
 		}
 		else{
 			cout << "Rejected by learner grammar:";
 			for (unsigned int j = 0; j < s.size(); j++)
-				cout << " " << s[j];
+				cout << " " << terminals.name(s[j]);
 			cout << endl;
 		}
 	}
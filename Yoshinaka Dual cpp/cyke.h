@@ -11,31 +11,50 @@
 #include <unordered_set>
 #include <vector>
 
+#include "chart.h"
+#include "cachefile.h"
+#include "earley.h"
+#include "membership.h"
+#include "prefixchart.h"
+#include "threadpool.h"
 #include "types.h"
+#include "valiant.h"
 
 using namespace::std;
 
+// Recognizer used by accepts()
+//   CYK_MATRIX: buildMatrix, one split point at a time
+//   VALIANT:    boolean matrix multiplication (see valiant.h), faster on long sentences
+//   EARLEY:     Earley recognizer on the rules as written (see earley.h)
+//   PREFIX:     buildMatrix column by column, reusing the columns of earlier queries
+//               that start the same way (see prefixchart.h)
+// The empty sentence always goes to EARLEY, as the CYK engines cannot derive it
+enum CYKEngine{ CYK_MATRIX, VALIANT, EARLEY, PREFIX };
+extern CYKEngine engineG;
+
 // A class to record what calls have been made
-class History{
+class History : public MembershipCache{
 public:
-	int checkHistory(const vector<string> w);
-	void add(string s, bool b);
-	int size(){ return map.size(); }
-private:
-	unordered_map<string, bool> map;
+	PrefixChart prefix;	// chart columns of earlier calls, for the PREFIX engine
+	CacheFile store;	// answers on disk, if the history was given a cache directory
 };
 
 // History classes for CFG to be accessed anywhere (CFGC histories are instantiated in each CFGC)
 extern History historyG; // History for target grammar G
+extern thread_local BitChart chartG; // Chart buildMatrix reuses across calls, one per thread
 
 
-unordered_map<string, bool> buildNullable(const CFG &G);
-unordered_map<string, unordered_set<string>> buildChains(const CFG &G, unordered_map<string, bool> nullable);
+// Works out G's nullable nonterminals, chains and rule tables, for G.compiled
+CompiledGrammar compile(const CFG &G);
 
-bool accepts(const vector<string> &w, const CFG &G, History &history);
-bool accepts(const vector<string> &w, const CFG &G, const unordered_map<string, unordered_set<string>> &chain, History &history);
+// C is G's compiled form (normally G.compiled)
+bool accepts(const vector<symbol> &w, const CFG &G, const CompiledGrammar &C, History &history);
+// Answers every string of ws at once (bit i of the result for ws[i])
+// Strings in the history or repeated in ws are only parsed once, the rest in parallel
+vector<word> acceptsBatch(const vector<vector<symbol>> &ws, const CFG &G, const CompiledGrammar &C,
+	History &history, ThreadPool &pool = sharedPool());
 
 void checkSamples(const CFG &G);
-void checkLearner(const CFG &G, History h, const vector<vector<string>> &samples);
+void checkLearner(const CFG &G, History &h, const vector<vector<symbol>> &samples);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,136 @@
+/****************************************************************
+ * File: earley.cpp
+ * Implements earley.h
+ ****************************************************************/
+#include <algorithm>
+
+#include "earley.h"
+
+EarleyRecognizer::EarleyRecognizer(const CFG &G, const CompiledGrammar &C){
+	unsigned int nt = C.nonterminals;
+	rulesOf.resize(nt);
+	nullable.assign(nt, false);
+	predicted.assign(nt, 0);
+	count.assign(nt, 0);
+	base = used = 0;
+
+	auto rule = [&](symbol A, const vector<Slot> &rhs){
+		rulesOf[A].push_back(slots.size());
+		slots.insert(slots.end(), rhs.begin(), rhs.end());
+		Slot end = { END, A };
+		slots.push_back(end);
+	};
+	for (auto &p0 : G.vp0)
+		rule(p0.lhs, vector<Slot>());
+	for (auto &p1 : G.vp1)
+		rule(p1.lhs, vector<Slot>{ { NONTERMINAL, p1.rhs } });
+	for (auto &p2 : G.vp2)
+		rule(p2.lhs, vector<Slot>{ { NONTERMINAL, p2.rhs1 }, { NONTERMINAL, p2.rhs2 } });
+	for (auto &pl : G.vpl)
+		rule(pl.lhs, vector<Slot>{ { TERMINAL, pl.rhs } });
+
+	for (symbol A = 0; A < nt; A++)
+		nullable[A] = testBit(C.nullable.data(), A);
+}
+
+void EarleyRecognizer::add(unsigned int set, unsigned int dot, unsigned int origin){
+	unsigned int &last = added[(size_t)origin * slots.size() + dot];
+	if (last == number(set))
+		return;
+	last = number(set);
+	Item item = { dot, origin };
+	sets[set].push_back(item);
+}
+
+void EarleyRecognizer::predict(unsigned int set, symbol A){
+	if (predicted[A] == set + 1)
+		return;
+	predicted[A] = set + 1;
+	for (unsigned int first : rulesOf[A])
+		add(set, first, set);
+}
+
+// Moves the items of the set just done that wait on a nonterminal into a run per
+// nonterminal at the end of waitingItems, so the completer reads them in one sweep
+void EarleyRecognizer::group(unsigned int set){
+	if (touched.empty())
+		return;
+	size_t nt = rulesOf.size();
+	size_t end = waitingItems.size();
+	for (symbol B : touched){
+		waiting[set * nt + B] = (uint64_t)number(set) << 32 | (end + 1);
+		size_t size = count[B];
+		count[B] = end;		// now where B's next item goes
+		end += size;
+	}
+	// The last run ends at an item waiting on no nonterminal, as the next set's first could have the same B
+	Waiting none = { 0, (symbol)-1 };
+	waitingItems.resize(end + 1, none);
+	for (const Waiting &wait : pending)
+		waitingItems[count[wait.B]++] = wait;
+	for (symbol B : touched)
+		count[B] = 0;
+	touched.clear();
+	pending.clear();
+}
+
+bool EarleyRecognizer::recognize(const vector<symbol> &w, const unordered_set<symbol> &starts){
+	unsigned int n = w.size();
+	size_t nt = rulesOf.size();
+	if (sets.size() < n + 1){
+		sets.resize(n + 1);
+		added.resize((size_t)(n + 1) * slots.size(), 0);
+		waiting.resize((size_t)(n + 1) * nt, 0);
+	}
+	for (unsigned int i = 0; i <= n; i++)
+		sets[i].clear();
+	fill(predicted.begin(), predicted.end(), 0);
+	if (used > 0xffffffffu - (n + 1)){	// out of numbers, so start again from clean arrays
+		fill(added.begin(), added.end(), 0);
+		fill(waiting.begin(), waiting.end(), 0);
+		used = 0;
+	}
+	base = used;
+	used += n + 1;
+	waitingItems.clear();
+
+	for (auto S : starts)
+		if (S < nt)
+			predict(0, S);
+
+	for (unsigned int i = 0; i <= n; i++){
+		// The set grows while it is processed
+		for (unsigned int k = 0; k < sets[i].size(); k++){
+			Item item = sets[i][k];
+			const Slot &next = slots[item.dot];
+			if (next.kind == NONTERMINAL){		// Predictor
+				if (count[next.s]++ == 0)
+					touched.push_back(next.s);
+				Waiting wait = { k, next.s };
+				pending.push_back(wait);
+				predict(i, next.s);
+				if (nullable[next.s])
+					add(i, item.dot + 1, item.origin);
+			}
+			else if (next.kind == TERMINAL){	// Scanner
+				if (i < n && w[i] == next.s)
+					add(i + 1, item.dot + 1, item.origin);
+			}
+			else if (item.origin < i){		// Completer (empty rules were stepped over)
+				uint64_t first = waiting[item.origin * nt + next.s];
+				if (first >> 32 != number(item.origin))
+					continue;
+				for (size_t j = (unsigned int)first - 1; waitingItems[j].B == next.s; j++){
+					const Item &parent = sets[item.origin][waitingItems[j].item];
+					add(i, parent.dot + 1, parent.origin);
+				}
+			}
+		}
+		group(i);
+	}
+
+	for (const Item &item : sets[n])
+		if (item.origin == 0 && slots[item.dot].kind == END && starts.count(slots[item.dot].s))
+			return true;
+	return false;
+}
@@ -0,0 +1,71 @@
+/****************************************************************
+ * File: earley.h
+ * Earley recognizer over the rules of a CFG as they are written
+ ****************************************************************/
+#ifndef _EARLEY_
+#define _EARLEY_
+
+#include <cstdint>
+#include <unordered_set>
+#include <vector>
+
+#include "types.h"
+
+// Recognizer that works on the P0, P1, P2 and PL rules directly, without chains or
+// a normal form, so it also decides the empty sentence
+//
+// Every rule's right hand side is laid out in one array, followed by an END slot
+// naming its left hand side.  An item is a position in that array (the dot) and the
+// set the rule was predicted in.  Nullable nonterminals are stepped over when they
+// are predicted (Aycock & Horspool 2002), so empty rules never need completing.
+// Which nonterminals are nullable comes from the compiled grammar.
+// An item only ever goes into later sets than before (items after a terminal go
+// into the next set, all others into the current one), so remembering the last set
+// each item went into is enough to keep the sets free of duplicates.
+// That and the items waiting on each nonterminal are kept in arrays over every
+// (set, item) and (set, nonterminal) that are only allocated when a sentence is longer
+// than any before.  Every entry holds a number for the set that wrote it, with no
+// number used by two queries, so a query never clears them and only touches the
+// entries it uses.
+class EarleyRecognizer{
+public:
+	// C is G's compiled form, for its nullable set
+	EarleyRecognizer(const CFG &G, const CompiledGrammar &C);
+	// True if one of starts derives w
+	bool recognize(const vector<symbol> &w, const unordered_set<symbol> &starts);
+private:
+	enum SlotKind{ NONTERMINAL, TERMINAL, END };
+	struct Slot{
+		SlotKind kind;
+		symbol s;	// the symbol after the dot, or the left hand side at END
+	};
+	struct Item{
+		unsigned int dot;	// index into slots
+		unsigned int origin;	// set the rule was predicted in
+	};
+	struct Waiting{
+		unsigned int item;	// index in its set
+		symbol B;
+	};
+
+	vector<Slot> slots;
+	vector<vector<unsigned int>> rulesOf;	// A -> first slot of every rule of A
+	vector<bool> nullable;
+	vector<vector<Item>> sets;
+	vector<unsigned int> predicted;		// A -> 1 + last set A was predicted in
+	// Set i of a query is numbered base + i + 1, above any number an earlier query used
+	unsigned int base, used;
+	unsigned int number(unsigned int set) const { return base + set + 1; }
+	vector<unsigned int> added;		// (origin, dot) -> number of the last set the item went into
+	vector<uint64_t> waiting;		// (set, B) -> set's number << 32 | 1 + first of the items waiting on B
+	vector<Waiting> waitingItems;		// a run per (set, B), each set's after the last set's
+	vector<Waiting> pending;		// the current set's, until it is done
+	vector<unsigned int> count;		// B -> items of the current set waiting on B
+	vector<symbol> touched;			// every B with a count
+
+	void add(unsigned int set, unsigned int dot, unsigned int origin);
+	void predict(unsigned int set, symbol A);
+	void group(unsigned int set);
+};
+
+#endif
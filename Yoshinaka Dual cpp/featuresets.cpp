@@ -0,0 +1,41 @@
+/****************************************************************
+ * File: featuresets.cpp
+ * Implementation for featuresets.h
+ ****************************************************************/
+#include <algorithm>
+
+#include "featuresets.h"
+
+FeatureSetTable featureSets;
+
+// Orders contexts by left side, then right side
+static bool before(const context &a, const context &b){
+	if (a.lhs != b.lhs)
+		return a.lhs < b.lhs;
+	return a.rhs < b.rhs;
+}
+
+// Does the sorted set s hold exactly the contexts of C?
+static bool same(const vector<context> &s, const contextSet &C){
+	if (s.size() != C.set.size())
+		return false;
+	for (auto &c : s)
+		if (C.set.find(c) == C.set.end())
+			return false;
+	return true;
+}
+
+// Returns the id of the set C, giving it the next free id if it is new
+// C's cached hash picks the bucket, so a set is only sorted the first time it is seen
+unsigned int FeatureSetTable::intern(const contextSet &C){
+	auto range = ids.equal_range(C.hash);
+	for (auto it = range.first; it != range.second; ++it)
+		if (same(sets[it->second], C))
+			return it->second;
+	vector<context> c(C.set.begin(), C.set.end());
+	sort(c.begin(), c.end(), before);
+	unsigned int id = sets.size();
+	ids.emplace(C.hash, id);
+	sets.push_back(c);
+	return id;
+}
@@ -0,0 +1,36 @@
+/****************************************************************
+ * File: featuresets.h
+ * Interned context sets, so contextual rules are tuples of ids
+ ****************************************************************/
+#ifndef _FEATURESETS_
+#define _FEATURESETS_
+
+#include <unordered_map>
+#include <vector>
+
+#include "types.h"
+
+using namespace::std;
+
+// Gives every distinct set of contexts a dense id (0, 1, 2, ...) and keeps it once,
+// as a sorted vector.  Two sets are equal exactly when their ids are.
+class FeatureSetTable{
+public:
+	unsigned int intern(const contextSet &C);
+	const vector<context> &contexts(unsigned int id) const { return sets[id]; }
+	// Does set id hold the empty context (λ, λ)?  It sorts first if it does.
+	bool hasEmpty(unsigned int id) const {
+		return !sets[id].empty() && sets[id][0].lhs.empty() && sets[id][0].rhs.empty();
+	}
+	unsigned int size() const { return sets.size(); }
+	// Forgets every set, so ids start from 0 again; rules holding old ids must go first
+	void clear(){ ids.clear(); sets.clear(); }
+private:
+	unordered_multimap<size_t, unsigned int> ids;	// contextSet::hash of a set -> its id
+	vector<vector<context>> sets;			// id -> sorted set
+};
+
+// Context sets of every contextual rule, shared like terminals
+extern FeatureSetTable featureSets;
+
+#endif
@@ -0,0 +1,63 @@
+/****************************************************************
+ * File: incidence.cpp
+ * Implementation for incidence.h
+ ****************************************************************/
+#include "cyke.h"
+#include "featuresets.h"
+#include "incidence.h"
+
+void Incidence::add(const context &c){
+	if (index.emplace(c, contexts.size()).second)
+		contexts.push_back(c);
+}
+
+void Incidence::update(const contextSet &F, const vector<vector<symbol>> &K, const CFG &G){
+	unsigned int oldContexts = columns.size();	// contexts given to add() have no column yet
+	for (auto &c : F.set)
+		add(c);
+
+	// Old contexts with the new strings, then new contexts with all of K, in one batch
+	vector<vector<symbol>> queries;
+	auto ask = [&](unsigned int j, unsigned int k){
+		const context &c = contexts[j];
+		vector<symbol> lur(c.lhs);
+		lur.insert(lur.end(), K[k].begin(), K[k].end());
+		lur.insert(lur.end(), c.rhs.begin(), c.rhs.end());
+		queries.push_back(lur);
+	};
+	auto first = [&](unsigned int j){
+		return j < oldContexts ? strings : 0;
+	};
+	for (unsigned int j = 0; j < contexts.size(); j++)
+		for (unsigned int k = first(j); k < K.size(); k++)
+			ask(j, k);
+	vector<word> in = acceptsBatch(queries, G, G.compiled, historyG);
+
+	KW = bitWords(K.size());
+	columns.resize(contexts.size());
+	size_t q = 0;
+	for (unsigned int j = 0; j < contexts.size(); j++){
+		columns[j].resize(KW, 0);
+		for (unsigned int k = first(j); k < K.size(); k++, q++)
+			if (testBit(in.data(), q))
+				setBit(columns[j].data(), k);
+	}
+	strings = K.size();
+}
+
+const vector<word> &Incidence::CK(unsigned int id){
+	Extent &e = cks[id];	// value initialized, so a new one has no strings
+	if (e.strings == strings)
+		return e.bits;
+
+	// The new strings, strings e.strings .. strings-1, that every context takes
+	vector<word> add(KW, 0);
+	for (unsigned int k = e.strings; k < strings; k++)
+		setBit(add.data(), k);
+	for (auto &c : featureSets.contexts(id))
+		andBits(add.data(), column(index.at(c)), KW);
+	e.bits.resize(KW, 0);
+	orBits(e.bits.data(), add.data(), KW);
+	e.strings = strings;
+	return e.bits;
+}
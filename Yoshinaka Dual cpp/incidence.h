@@ -0,0 +1,52 @@
+/****************************************************************
+ * File: incidence.h
+ * Which strings of K each context of F puts in the target
+ * language, and CK of each interned set of contexts, kept and
+ * extended across calls to Hf
+ ****************************************************************/
+#ifndef _INCIDENCE_
+#define _INCIDENCE_
+
+#include <unordered_map>
+#include <vector>
+
+#include "bitset.h"
+#include "types.h"
+
+using namespace::std;
+
+// Membership of l w r for every context (l, r) of F and string w of K, kept as one
+// bitset over K (a column) per context.  F and K may only grow between calls to
+// update(), K only at its end, and update() only asks about the new pairs.
+// A context keeps the index it is first given.
+class Incidence{
+public:
+	Incidence()
+		: strings(0), KW(0) {}
+	void update(const contextSet &F, const vector<vector<symbol>> &K, const CFG &G);
+	// Gives c the next index if it has none, so a restored run numbers its contexts
+	// as the saved one did.  Its column is filled by the next update().
+	void add(const context &c);
+	unsigned int size() const { return contexts.size(); }
+	unsigned int words() const { return KW; }	// words in a bitset over K
+	const context &at(unsigned int j) const { return contexts[j]; }
+	const word* column(unsigned int j) const { return columns[j].data(); }
+	// CK of the set with this id in featureSets, as a bitset over K.  Every context of
+	// the set must be in F.  The result is kept, and later calls only add the strings
+	// K gained since.  The reference stays good until the next call to update().
+	const vector<word> &CK(unsigned int id);
+private:
+	typedef struct{
+		unsigned int strings;	// strings of K already in bits
+		vector<word> bits;
+	} Extent;
+
+	vector<context> contexts;
+	unordered_map<context, unsigned int> index;	// context -> its index in contexts
+	vector<vector<word>> columns;
+	unsigned int strings;	// strings of K in the columns
+	unsigned int KW;
+	unordered_map<unsigned int, Extent> cks;	// feature set id -> its CK
+};
+
+#endif
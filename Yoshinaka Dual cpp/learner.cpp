@@ -0,0 +1,348 @@
+/****************************************************************
+ * File: learner.cpp
+ * Yoshinaka algorithm, implements learner.h
+ ****************************************************************/
+#include <algorithm>
+#include <iostream>
+#include <set>
+
+#include "featuresets.h"
+#include "learner.h"
+
+using namespace::std;
+
+// Just like python version
+void addSub(vector<vector<symbol>> &SubD, const vector<symbol> w){
+	for (unsigned int i = 0; i < w.size(); i++){
+		for (unsigned int j = i; j <= w.size(); j++){
+			vector<symbol> temp;
+			for (unsigned int k = i; k < j; k++) // Python: s=w[i:j]
+				temp.push_back(w[k]);
+
+			if (!search(SubD, temp)) // If temp is not already in ConD, add it
+				SubD.push_back(temp);
+		}
+	}
+}
+
+// Just like python vesion
+void addCon(contextSet &ConD, const vector<symbol> w){
+	for (unsigned int i = 0; i <= w.size(); i++){
+		for (unsigned int j = i; j <= w.size() + 1; j++){
+			vector<symbol> lhs(w.begin(), w.begin() + i);
+			vector<symbol> rhs(w.begin() + min(j, (unsigned int)w.size()), w.end());
+			ConD.add(context(lhs, rhs));
+		}
+	}
+}
+
+void newP0C(const contextSet &C, unsigned int id, P0CSet &sp0c, const CFG &G){
+	vector<vector<symbol>> queries;
+	for (auto c : C.set){
+		vector<symbol> lur;
+		for (auto s : c.lhs)
+			lur.push_back(s);
+		for (auto s : c.rhs)
+			lur.push_back(s);
+		queries.push_back(lur);
+	}
+	vector<word> in = acceptsBatch(queries, G, G.compiled, historyG);
+	for (size_t i = 0; i < queries.size(); i++)
+		if (!testBit(in.data(), i))
+			return;
+	P0C p0c(id);
+	sp0c.set.emplace(p0c);
+}
+
+// Vf[i] has the id ids[i] in featureSets, and CK(Vf[i]) is the strings of K at cks[i]
+void newP2C(const contextSet &C, unsigned int id, const vector<contextSet> &Vf, const vector<unsigned int> &ids,
+	const vector<vector<unsigned int>> &cks, const vector<vector<symbol>> &K, P2CSet &sp2c, const CFG &G){
+	for (unsigned int i1 = 0; i1 < Vf.size(); i1++){
+		for (unsigned int i2 = 0; i2 < Vf.size(); i2++){
+			bool b = true;
+			for (auto &c : C.set){
+				for (auto k1 : cks[i1]){
+					for (auto k2 : cks[i2]){
+						vector<symbol> lur(c.lhs);
+						lur.insert(lur.end(), K[k1].begin(), K[k1].end());
+						lur.insert(lur.end(), K[k2].begin(), K[k2].end());
+						lur.insert(lur.end(), c.rhs.begin(), c.rhs.end());
+						if (!accepts(lur, G, G.compiled, historyG)){
+							b = false;
+							break;
+						}
+					}
+					if (!b)
+						break;
+				}
+				if (!b)
+					break;
+			}
+			if (b){
+				P2C p2c(id, ids[i1], ids[i2]);
+				sp2c.set.emplace(p2c);
+			}
+		}
+	}
+}
+
+void newPLC(const contextSet &C, unsigned int id, PLCSet &splc, const CFG &G, const unordered_set<symbol> &sigma){
+	vector<vector<symbol>> queries;
+	for (auto x : sigma){
+		for (auto c : C.set){
+			vector<symbol> lur;
+			for (auto s : c.lhs)
+				lur.push_back(s);
+			lur.push_back(x);
+			for (auto s : c.rhs)
+				lur.push_back(s);
+			queries.push_back(lur);
+		}
+	}
+	vector<word> in = acceptsBatch(queries, G, G.compiled, historyG);
+
+	size_t q = 0;
+	for (auto x : sigma){
+		bool b = true;
+		for (size_t i = 0; i < C.set.size(); i++, q++)
+			if (!testBit(in.data(), q))
+				b = false;
+		if (b){
+			PLC plc(id, x);
+			splc.set.emplace(plc);
+		}
+	}
+}
+
+void newP1C(const P0CSet &sp0c, P1CSet &sp1c, const P2CSet &sp2c,
+	const PLCSet &splc, const CFG &G)
+{
+	context c = context();
+	contextSet cs;
+	cs.add(c);
+	unsigned int id = featureSets.intern(cs);
+	for (auto r : sp0c.set){ // For each P0C rule
+		if (featureSets.hasEmpty(r.lhs)){
+			P1C p1c(id, r.lhs);
+			sp1c.set.emplace(p1c);
+		}
+	}
+	for (auto r : sp2c.set){ // For each P2C rule
+		if (featureSets.hasEmpty(r.lhs)){
+			P1C p1c(id, r.lhs);
+			sp1c.set.emplace(p1c);
+		}
+	}
+	for (auto r : splc.set){ // For each PLC rule
+		if (featureSets.hasEmpty(r.lhs)){
+			P1C p1c(id, r.lhs);
+			sp1c.set.emplace(p1c);
+		}
+	}
+}
+
+// Every context of I shared by the strings of ext (a bitset over K)
+vector<word> closure(const Incidence &I, const vector<word> &ext){
+	vector<word> C(bitWords(I.size()), 0);
+	for (unsigned int j = 0; j < I.size(); j++)
+		if (containsBits(I.column(j), ext.data(), I.words()))
+			setBit(C.data(), j);
+	return C;
+}
+
+// Adds to Vf every set made from set by adding contexts after last, up to f more
+// Sets are bitsets over the contexts of I.  set is changed in place and left as it was.
+void extendVf(const Incidence &I, vector<word> &set, int last, int f, vector<word> &Vf){
+	unsigned int n = I.size();
+	for (unsigned int i = last + 1; i < n; i++){
+		setBit(set.data(), i);
+		Vf.insert(Vf.end(), set.begin(), set.end());
+		if (f > 1)
+			extendVf(I, set, i, f - 1, Vf);
+		clearBit(set.data(), i);
+	}
+}
+
+// The closures of every set of up to f contexts, each once (the closure of the
+// empty set only if it isn't empty)
+// closure(S + c) = closure(closure(S) + c), so the closures of k + 1 contexts are
+// the closures of k contexts with one more context added and closed again, and the
+// sets found depend only on I, not on the order of its contexts.  A closed set's
+// extent is the extent of any set it is the closure of.
+void closedVf(const Incidence &I, const vector<word> &all, int f, vector<word> &Vf){
+	unsigned int n = I.size();
+	vector<word> first = closure(I, all);	// the contexts all of K shares
+	if (countBits(first.data(), first.size()) > 0)
+		Vf.insert(Vf.end(), first.begin(), first.end());
+	set<vector<word>> seen = { first };
+	vector<pair<vector<word>, vector<word>>> level = { { first, all } };	// sets and their extents
+	for (int k = 0; k < f && !level.empty(); k++){
+		vector<pair<vector<word>, vector<word>>> next;
+		for (auto &C : level)
+			for (unsigned int i = 0; i < n; i++){
+				if (testBit(C.first.data(), i))
+					continue;
+				vector<word> e(C.second);
+				andBits(e.data(), I.column(i), I.words());
+				vector<word> S = closure(I, e);
+				if (!seen.insert(S).second)
+					continue;
+				Vf.insert(Vf.end(), S.begin(), S.end());
+				next.push_back({ S, e });
+			}
+		level.swap(next);
+	}
+}
+
+// Every set of 1 to f contexts of F, or with closed the closures of every set of up
+// to f contexts, as bitsets over the contexts of I laid end to end
+vector<word> enumerateVf(const Incidence &I, unsigned int strings, int f, bool closed){
+	vector<word> Vf;
+	if (closed){
+		vector<word> all(I.words(), 0);
+		for (unsigned int k = 0; k < strings; k++)
+			setBit(all.data(), k);
+		closedVf(I, all, f, Vf);
+	}
+	else{
+		vector<word> set(bitWords(I.size()), 0);
+		extendVf(I, set, -1, f, Vf);
+	}
+	return Vf;
+}
+
+// Create a Conditional CFG Grammar from F and K
+// I holds the answers of earlier calls, K and F may only have grown since
+CFGC Hf(const contextSet &F, const vector<vector<symbol>> &K, const CFG &G,
+	const unordered_set<symbol> &sigma, const int f, const bool closed, Incidence &I)
+{
+	// printContextSet(F.set);
+	// printD(K);
+	CFGC H;
+	I.update(F, K, G);
+	unsigned int FW = bitWords(I.size());
+	vector<word> masks = enumerateVf(I, K.size(), f, closed);
+	// Each set is interned once, the rules only hold the ids
+	vector<contextSet> Vf;
+	vector<unsigned int> ids;
+	vector<vector<unsigned int>> cks;	// CK of each set, as indices into K
+	for (size_t m = 0; m < masks.size(); m += FW){
+		contextSet Cset;
+		forEachBit(&masks[m], FW, [&](unsigned int j){
+			Cset.add(I.at(j));
+		});
+		//printContextSet(Cset.set);
+		Vf.push_back(Cset);
+		ids.push_back(featureSets.intern(Cset));
+		cks.push_back(vector<unsigned int>());
+		forEachBit(I.CK(ids.back()).data(), I.words(), [&](unsigned int k){
+			cks.back().push_back(k);
+		});
+	}
+	for (unsigned int i = 0; i < Vf.size(); i++){ // Vf[i] is a set of contexts
+		newP0C(Vf[i], ids[i], H.sp0c, G);
+		newP2C(Vf[i], ids[i], Vf, ids, cks, K, H.sp2c, G);
+		newPLC(Vf[i], ids[i], H.splc, G, sigma);
+	}
+	newP1C(H.sp0c, H.sp1c, H.sp2c, H.splc, G);
+	// printCFGC(H);
+	return H;
+}
+
+
+bool notInLhat(vector<vector<symbol>> D, CFG &Hprime, History &history){
+	//if (Hprime.vp0.size() + Hprime.vp1.size() + Hprime.vp2.size()
+	//	+ Hprime.vpl.size() == 0) // If Hprime is empty, just return true
+	//	return true;
+	for (auto s : D){
+		// printCFG(Hprime);
+		if (!accepts(s, Hprime, Hprime.compiled, history)){
+			cout << "Not in Lhat" << endl;
+			return true;
+		}
+	}
+	cout << "In Lhat" << endl;
+	return false;
+}
+
+DualLearner::DualLearner(const CFG &t, const int fs, const bool c)
+	: target(t), f(fs), closed(c) {
+	for (auto pl : target.vpl)
+		sigma.emplace(pl.rhs);
+	Hhat = Hf(F, K, target, sigma, f, closed, I);
+	Hprime = convertCFGC(Hhat);
+}
+
+void DualLearner::learn(const vector<symbol> &w){
+	D.push_back(w);
+	// printD(D);
+	addCon(ConD, w);
+	// printContextSet(ConD.set);
+	addSub(SubD, w);
+	// printSubstringVector(SubD);
+	K = SubD;
+	Hhat = Hf(F, K, target, sigma, f, closed, I);
+	Hprime = convertCFGC(Hhat);
+	History h;
+	grew.push_back(notInLhat(D, Hprime, h));
+	if (grew.back()){
+		for (auto c : ConD.set)
+			F.add(c);
+		Hhat = Hf(F, K, target, sigma, f, closed, I);
+		Hprime = convertCFGC(Hhat);
+	}
+
+	// printCFGC(Hhat);
+	// printCFG(Hprime);
+}
+
+Checkpoint DualLearner::state() const{
+	Checkpoint c;
+	c.f = f;
+	c.closed = closed;
+	c.D = D;
+	c.grew = grew;
+	for (unsigned int j = 0; j < I.size(); j++)
+		c.contexts.push_back(I.at(j));
+	for (unsigned int id = 0; id < featureSets.size(); id++)
+		c.sets.push_back(featureSets.contexts(id));
+	c.Hhat = Hhat;
+	return c;
+}
+
+// Takes the same steps on ConD, SubD and F as learn() did, then numbers the contexts
+// and interns the feature sets in the saved order.  The Incidence's cells are all
+// answered from the oracle's history.
+void DualLearner::restore(const Checkpoint &c){
+	for (size_t i = 0; i < c.D.size(); i++){
+		D.push_back(c.D[i]);
+		addCon(ConD, c.D[i]);
+		addSub(SubD, c.D[i]);
+		if (c.grew[i])
+			for (auto cx : ConD.set)
+				F.add(cx);
+	}
+	grew = c.grew;
+	K = SubD;
+	for (auto &cx : c.contexts)
+		I.add(cx);
+	I.update(F, K, target);
+
+	vector<unsigned int> ids;	// saved id -> id in this run, the same if featureSets started out alike
+	for (auto &s : c.sets){
+		contextSet C;
+		for (auto &cx : s)
+			C.add(cx);
+		ids.push_back(featureSets.intern(C));
+	}
+	Hhat = CFGC();
+	for (auto &r : c.Hhat.sp0c.set)
+		Hhat.sp0c.set.emplace(P0C(ids[r.lhs]));
+	for (auto &r : c.Hhat.sp1c.set)
+		Hhat.sp1c.set.emplace(P1C(ids[r.lhs], ids[r.rhs]));
+	for (auto &r : c.Hhat.sp2c.set)
+		Hhat.sp2c.set.emplace(P2C(ids[r.lhs], ids[r.rhs1], ids[r.rhs2]));
+	for (auto &r : c.Hhat.splc.set)
+		Hhat.splc.set.emplace(PLC(ids[r.lhs], r.rhs));
+	Hprime = convertCFGC(Hhat);
+}
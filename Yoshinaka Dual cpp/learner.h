@@ -0,0 +1,60 @@
+/****************************************************************
+ * File: learner.h
+ * Hf and the state of the dual algorithm between samples
+ ****************************************************************/
+#ifndef _LEARNER_
+#define _LEARNER_
+
+#include <unordered_set>
+#include <vector>
+
+#include "checkpoint.h"
+#include "cyke.h"
+#include "incidence.h"
+#include "types.h"
+
+using namespace::std;
+
+// Adds every substring of w to SubD that isn't in it yet
+void addSub(vector<vector<symbol>> &SubD, const vector<symbol> w);
+// Adds every context of w to ConD
+void addCon(contextSet &ConD, const vector<symbol> w);
+
+// Create a Conditional CFG Grammar from F and K
+// I holds the answers of earlier calls, K and F may only have grown since
+CFGC Hf(const contextSet &F, const vector<vector<symbol>> &K, const CFG &G,
+	const unordered_set<symbol> &sigma, const int f, const bool closed, Incidence &I);
+
+// Whether Hprime rejects a string of D
+bool notInLhat(vector<vector<symbol>> D, CFG &Hprime, History &history);
+
+// The state of the algorithm between samples, so samples can be given one at a
+// time and the hypothesis looked at in between
+class DualLearner{
+public:
+	DualLearner(const CFG &target, const int f, const bool closed);
+	// One step of the algorithm with the next sample w
+	void learn(const vector<symbol> &w);
+	const CFGC &rules() const { return Hhat; }
+	const CFG &hypothesis() const { return Hprime; }	// Hhat as a compiled CFG
+	const vector<vector<symbol>> &samples() const { return D; }
+	// The learner's state, for a checkpoint, and back
+	Checkpoint state() const;
+	void restore(const Checkpoint &c);
+private:
+	const CFG &target;
+	const int f;
+	const bool closed;
+	vector<vector<symbol>> D;
+	vector<char> grew;	// whether F took in ConD after each sample of D
+	vector<vector<symbol>> SubD;
+	vector<vector<symbol>> K;
+	contextSet F;
+	contextSet ConD;
+	unordered_set<symbol> sigma;
+	Incidence I;	// membership of F's contexts with K's strings, shared by every Hf
+	CFGC Hhat;
+	CFG Hprime;
+};
+
+#endif
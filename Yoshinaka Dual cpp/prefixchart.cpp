@@ -0,0 +1,88 @@
+/****************************************************************
+ * File: prefixchart.cpp
+ * Implements prefixchart.h
+ ****************************************************************/
+#include "prefixchart.h"
+
+PrefixChart::PrefixChart(size_t m)
+	: maxWords(m) {
+	clear();
+}
+
+void PrefixChart::clear(){
+	first.assign(1, 0);
+	bits.clear();
+	counts.clear();
+	fans.clear();
+	edges.clear();
+}
+
+// Adds column j of the sentence on path, whose last symbol is a, as a new node
+// Cells are filled bottom up: (i, j) splits into (i, h), from an earlier column, and
+// (h, j), from this column, which is already done because h > i.
+// The split points pick between the pair index and the byLeft entries as in buildMatrix.
+void PrefixChart::extend(symbol a, unsigned int j, const GrammarIndex &index){
+	unsigned int W = index.ntWords;
+	size_t column = counts.size();
+	first.push_back(column);
+	bits.resize(bits.size() + (size_t)j * W, 0);
+	counts.resize(column + j, 0);
+	fans.resize(column + j, 0);
+
+	for (unsigned int i = j; i-- > 0;){
+		word* cell = &bits[(column + i) * W];
+		if (i == j - 1){
+			const word* As = index.lexical(a);
+			if (As != NULL)
+				orBits(cell, As, W);
+		}
+		for (unsigned int h = i + 1; h < j; h++){
+			size_t left = first[path[h]] + i, right = column + h;
+			unsigned int lsize = counts[left], rsize = counts[right];
+			if (lsize == 0 || rsize == 0)
+				continue;
+			const word* l = &bits[left * W];
+			const word* r = &bits[right * W];
+			if (lsize * rsize < fans[left]){
+				forEachBit(l, W, [&](unsigned int B){
+					forEachBit(r, W, [&](unsigned int C){
+						const word* As = index.parents(B, C);
+						if (As)
+							orBits(cell, As, W);
+					});
+				});
+			}
+			else{
+				forEachBit(l, W, [&](unsigned int B){
+					for (const BinaryEntry &e : index.byLeft(B))
+						if (testBit(r, e.right))
+							orBits(cell, &index.parentSets[e.parents], W);
+				});
+			}
+		}
+		forEachBit(cell, W, [&](unsigned int B){
+			counts[column + i]++;
+			fans[column + i] += index.byLeft(B).size();
+		});
+	}
+}
+
+const word* PrefixChart::parse(const vector<symbol> &w, const GrammarIndex &index){
+	unsigned int n = w.size();
+	if (bits.size() > maxWords)
+		clear();
+	path.assign(1, 0);
+	for (unsigned int j = 1; j <= n; j++){
+		uint64_t key = (uint64_t)path.back() << 32 | w[j - 1];
+		auto it = edges.find(key);
+		if (it != edges.end()){
+			path.push_back(it->second);
+			continue;
+		}
+		unsigned int node = first.size();
+		edges.emplace(key, node);
+		extend(w[j - 1], j, index);
+		path.push_back(node);
+	}
+	return &bits[first[path[n]] * index.ntWords];
+}
@@ -0,0 +1,47 @@
+/****************************************************************
+ * File: prefixchart.h
+ * CYK chart that keeps the columns of earlier sentences in a
+ * trie of their prefixes
+ ****************************************************************/
+#ifndef _PREFIXCHART_
+#define _PREFIXCHART_
+
+#include <unordered_map>
+#include <vector>
+
+#include "bitset.h"
+#include "types.h"
+
+// CYK chart filled left to right, one column per sentence position, with the columns
+// of recent sentences kept in a trie of their prefixes
+//
+// Column j holds the cells (i, j), i < j, and depends only on w[0..j), so a sentence
+// that starts like one parsed before reuses that sentence's columns and only computes
+// the columns of its new suffix.  The learners build queries as l ++ w ++ r with the
+// contexts of a few samples, so most queries share a long prefix with an earlier one.
+//
+// The trie caches results for one grammar, like an oracle's history: call clear()
+// before parsing with a different index.  When the columns outgrow maxWords the
+// whole trie is dropped and rebuilt from the sentences that follow.
+class PrefixChart{
+public:
+	PrefixChart(size_t maxWords = (size_t)1 << 20);
+	// Returns {A | A derives w} (w must not be empty), valid until the next parse
+	const word* parse(const vector<symbol> &w, const GrammarIndex &index);
+	void clear();
+	size_t size() const { return first.size() - 1; }	// prefixes in the trie
+private:
+	// Node k of the trie is the column of its prefix: cells (i, depth) for i < depth,
+	// stored from cell first[k] on.  The cells of all nodes sit in three flat arrays.
+	vector<size_t> first;				// first[0] is the empty prefix
+	vector<word> bits;				// W words per cell
+	vector<unsigned int> counts;			// nonterminals in each cell
+	vector<unsigned int> fans;			// index entries of the nonterminals in each cell
+	unordered_map<uint64_t, unsigned int> edges;	// (node, next symbol) -> child node
+	vector<unsigned int> path;			// nodes of the sentence being parsed, by depth
+	size_t maxWords;
+
+	void extend(symbol a, unsigned int j, const GrammarIndex &index);
+};
+
+#endif
@@ -0,0 +1,42 @@
+/****************************************************************
+ * File: samplereader.cpp
+ * Implementation for samplereader.h
+ ****************************************************************/
+#include <iostream>
+
+#include "samplereader.h"
+
+SampleReader::SampleReader(const string &path)
+	: in(NULL), lines(0) {
+	if (path == "-")
+		in = &cin;
+	else {
+		file.open(path);
+		if (file.is_open())
+			in = &file;
+	}
+}
+
+bool SampleReader::next(vector<symbol> &w, bool &query){
+	while (in && getline(*in, line)){
+		lines++;
+		w.clear();
+		size_t i = 0;
+		query = !line.empty() && line[0] == '?';
+		if (query)
+			i++;
+		for (; i <= line.size(); i++){
+			if (i == line.size() || line[i] == ' ' || line[i] == '\t' || line[i] == '\r'){
+				if (!token.empty()){
+					w.push_back(terminals.intern(token));
+					token.clear();
+				}
+			}
+			else
+				token += line[i];
+		}
+		if (!w.empty() || query)
+			return true;
+	}
+	return false;
+}
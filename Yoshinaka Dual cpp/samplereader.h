@@ -0,0 +1,37 @@
+/****************************************************************
+ * File: samplereader.h
+ * Samples read and tokenized one line at a time, for streaming
+ ****************************************************************/
+#ifndef _SAMPLEREADER_
+#define _SAMPLEREADER_
+
+#include <fstream>
+#include <istream>
+#include <string>
+#include <vector>
+
+#include "symbols.h"
+
+using namespace::std;
+
+// Reads samples one line at a time from a file, or from stdin for "-", so a corpus
+// never has to be held in memory at once.  Each line is split on spaces and tabs and
+// its tokens go straight into terminal ids.  Blank lines are skipped.
+// A line that starts with '?' is a query: the rest of it is a string to test against
+// the current hypothesis instead of a sample to learn from.
+class SampleReader{
+public:
+	SampleReader(const string &path);
+	bool isOpen() const { return in != NULL; }
+	// Puts the next sample or query in w and returns true, or false at the end
+	bool next(vector<symbol> &w, bool &query);
+	unsigned long long lineCount() const { return lines; }
+private:
+	ifstream file;
+	istream* in;
+	string line;
+	string token;
+	unsigned long long lines;
+};
+
+#endif
@@ -0,0 +1,29 @@
+#ifndef _SYMBOLS_
+#define _SYMBOLS_
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace::std;
+
+// Dense integer id of a terminal or nonterminal
+typedef unsigned int symbol;
+
+// Maps every symbol name to a dense id (0, 1, 2, ...) and back
+class SymbolTable{
+public:
+	symbol intern(const string &s);
+	int find(const string &s) const;
+	const string &name(symbol id) const { return names[id]; }
+	unsigned int size() const { return names.size(); }
+	void reserve(size_t n);	// room for n symbols without rehashing
+private:
+	unordered_map<string, symbol> ids;
+	vector<string> names;
+};
+
+// Terminals are shared by the target grammar, the samples and the learner
+extern SymbolTable terminals;
+
+#endif
@@ -5,14 +5,53 @@
 ****************************************************************/
 #include "types.h"
 
+#include <cstdlib>
 #include <iostream>
 
+#include "cachefile.h"
+#include "cyke.h"
+#include "featuresets.h"
+#include "grammarfile.h"
+
+atomic<unsigned long long> compiledVersions(0);
+
+////////////////////////////////////////////////////////////////
+/* Context and contextual rule hash functions                 */
+////////////////////////////////////////////////////////////////
+
+void context::rehash(){
+	hash = mix64(fingerprint(lhs) ^ (fingerprint(rhs) * 0x9e3779b97f4a7c15ULL));
+}
+
+void contextSet::add(const context &c){
+	if (set.insert(c).second)
+		hash += mix64(c.hash);
+}
+
+namespace std {
+	size_t hash<P0C>::operator()(const P0C &p0c) const {
+		return mix64(p0c.lhs);
+	}
+
+	size_t hash<P1C>::operator()(const P1C &p1c) const {
+		return mix64(((uint64_t)p1c.lhs << 32) | p1c.rhs);
+	}
+
+	size_t hash<P2C>::operator()(const P2C &p2c) const {
+		return mix64(mix64(((uint64_t)p2c.lhs << 32) | p2c.rhs1) ^ p2c.rhs2);
+	}
+
+	size_t hash<PLC>::operator()(const PLC &plc) const {
+		return mix64(((uint64_t)plc.lhs << 32) | plc.rhs);
+	}
+}
+
 ////////////////////////////////////////////////////////////////
 /* Equality helper funcions                                   */
 ////////////////////////////////////////////////////////////////
 
-// Check if two string vectors are equal
-bool equal(vector<string> a, vector<string> b){
+// Check if two symbol vectors are equal
+bool equal(vector<symbol> a, vector<symbol> b){
 	if (a.size() != b.size())
 		return false;
 	for (unsigned int i = 0; i < a.size(); i++)
@@ -43,8 +82,8 @@ bool equal(vector<context> a, vector<context> b){
 /* Vector search utility functions */
 /////////////////////////////////////
 
-// Search for a string w in vector v
-bool search(vector<string> v, string w){
+// Search for a symbol w in vector v
+bool search(vector<symbol> v, symbol w){
 	for (unsigned int i = 0; i < v.size(); i++)
 		if (v[i] == w)
 			return true;
@@ -68,7 +107,7 @@ bool search(vector<vector<context>> v2, context c){
 }
 
 // Search for a subset string in a list of subsets
-bool search(vector<vector<string>> v, vector<string> s){
+bool search(vector<vector<symbol>> v, vector<symbol> s){
 	for (unsigned int i = 0; i < v.size(); i++)
 		if (equal(v[i], s))
 			return true;
@@ -105,18 +144,73 @@ bool subset(vector<context> c1, vector<vector<context>> cl){
 /* Utility and Print Functions                                */
 ////////////////////////////////////////////////////////////////
 
+// Splits a rule line "lhs -> rhs" into its left side and the symbols of its right side,
+// which are separated by commas or whitespace.  A line without an arrow is all left side.
+// Returns false for a blank line.
+static bool splitRule(const string &line, string &lhs, vector<string> &rhs){
+	size_t arrow = line.find("->");
+	string temp;
+	for (size_t i = 0; i <= line.size(); i++){
+		if (i == arrow){
+			lhs = temp;
+			temp = "";
+			i++;
+		}
+		else if (i == line.size() || line[i] == ',' || isspace((unsigned char)line[i])){
+			if (arrow == string::npos || i < arrow)
+				continue;	// the left side is one symbol, however it is spaced
+			if (!temp.empty())
+				rhs.push_back(temp);
+			temp = "";
+		}
+		else
+			temp += line[i];
+	}
+	if (arrow == string::npos)
+		lhs = temp;
+	return !lhs.empty() || !rhs.empty();
+}
+
+// Takes the weight off the end of rhs if it has one symbol more than a rule with
+// arity symbols on its right and that symbol is a number, and returns it, or 1
+static double splitWeight(vector<string> &rhs, size_t arity){
+	if (rhs.size() != arity + 1)
+		return 1;
+	const char* field = rhs.back().c_str();
+	char* end;
+	double weight = strtod(field, &end);
+	if (end == field || *end != '\0' || !(weight >= 0))
+		return 1;
+	rhs.pop_back();
+	return weight;
+}
+
 // Takes the input file and creates an CFG object for the target grammar
-CFG extractCFG(char* file){
+// The file may be text or a binary grammar written by writeBinaryGrammar
+CFG extractCFG(char* file, RuleWeights* weights){
 	if (file == NULL){
 		cout << "No input file given!" << endl;
 		exit(1);
 	}
 
+	CFG G;
+	if (isBinaryGrammar(file)){
+		if (!readBinaryGrammar(file, G)){
+			cout << "Unable to read binary grammar " << file << endl;
+			exit(1);
+		}
+		if (weights){
+			weights->p0.assign(G.vp0.size(), 1);
+			weights->p1.assign(G.vp1.size(), 1);
+			weights->p2.assign(G.vp2.size(), 1);
+			weights->pl.assign(G.vpl.size(), 1);
+		}
+		return G;
+	}
+
 	ifstream input(file);
 	string line;
 
-	CFG G;
-
 	if (input.is_open())
 	{
 		string type;
@@ -135,86 +229,46 @@ CFG extractCFG(char* file){
 			}
 
 			// Parse the line depending on what type it is
-			if (type == "P0"){
-				P0 p0;
-				string temp;
-				for (unsigned int i = 0; i < line.length(); i++)
-					if (isalpha(line[i]))
-						temp += line[i];
-				p0.lhs = temp;
-				G.vp0.push_back(p0);
+			string lhs;
+			vector<string> rhs;
+			if (type != "Samples" && !splitRule(line, lhs, rhs))
+				continue;	// blank line
+			double weight = 1;
+			if (type == "P0" || type == "P1" || type == "PL")
+				weight = splitWeight(rhs, type == "P0" ? 0 : 1);
+			else if (type == "P2")
+				weight = splitWeight(rhs, 2);
+			if (type == "P0" && rhs.empty() && !lhs.empty()){
+				G.vp0.push_back(P0(G.nonterminals.intern(lhs)));
+				if (weights)
+					weights->p0.push_back(weight);
 			}
-			else if (type == "P1"){
-				P1 p1;
-				string temp;
-				for (unsigned int i = 0; i < line.length(); i++){
-					if (isalpha(line[i]))
-						temp += line[i];
-					else if (line[i] == '-' && line[i + 1] == '>'){
-						p1.lhs = temp;
-						temp = "";
-						i++;
-					}
-					p1.rhs = temp;
-					G.vp1.push_back(p1);
-				}
-			}
-			else if (type == "P2"){
-				P2 p2;
-				string temp;
-				for (unsigned int i = 0; i < line.length(); i++){
-					if (line[i] == ' ' || line[i] == '\t')
-						continue;
-					else if (line[i] == '-' && line[i + 1] == '>'){
-						p2.lhs = temp;
-						temp = "";
-						i++;
-						continue;
-					}
-					else if (line[i] == ','){
-						p2.rhs1 = temp;
-						temp = "";
-						continue;
-					}
-					else
-						temp.push_back(line[i]);
-				}
-				p2.rhs2 = temp;
-				G.vp2.push_back(p2);
+			else if (type == "P1" && rhs.size() == 1){
+				G.vp1.push_back(P1(G.nonterminals.intern(lhs), G.nonterminals.intern(rhs[0])));
+				if (weights)
+					weights->p1.push_back(weight);
 			}
-			else if (type == "PL"){
-				PL pl;
-				string temp;
-				for (unsigned int i = 0; i < line.length(); i++){
-					if (line[i] == ' ' || line[i] == '\t')
-						continue;
-					else if (line[i] == '-' && line[i + 1] == '>'){
-						pl.lhs = temp;
-						temp = "";
-						i++;
-						continue;
-					}
-					else
-						temp.push_back(line[i]);
-				}
-				pl.rhs = temp;
-				G.vpl.push_back(pl);
+			else if (type == "P2" && rhs.size() == 2){
+				G.vp2.push_back(P2(G.nonterminals.intern(lhs), G.nonterminals.intern(rhs[0]),
+					G.nonterminals.intern(rhs[1])));
+				if (weights)
+					weights->p2.push_back(weight);
 			}
-			else if (type == "Starts"){
-				string temp;
-				for (unsigned int i = 0; i < line.length(); i++)
-					if (isalpha(line[i]))
-						temp += line[i];
-				G.starts.emplace(temp);
+			else if (type == "PL" && rhs.size() == 1){
+				G.vpl.push_back(PL(G.nonterminals.intern(lhs), terminals.intern(rhs[0])));
+				if (weights)
+					weights->pl.push_back(weight);
 			}
+			else if (type == "Starts" && rhs.empty() && !lhs.empty())
+				G.starts.emplace(G.nonterminals.intern(lhs));
 			else if (type == "Samples"){
 				string temp;
-				vector<string> w;
+				vector<symbol> w;
 				bool inword = false;
 				for (unsigned int i = 0; i < line.length(); i++){
 					if (line[i] == ' ' || line[i] == '\t'){
 						if (inword){
-							w.push_back(temp);
+							w.push_back(terminals.intern(temp));
 							temp = "";
 							inword = false;
 						}
@@ -227,7 +281,7 @@ CFG extractCFG(char* file){
 					}
 				}
 				if (inword)
-					w.push_back(temp);
+					w.push_back(terminals.intern(temp));
 				G.samples.push_back(w);
 			}
 			else // The input file is improperly formatted
@@ -238,7 +292,7 @@ CFG extractCFG(char* file){
 
 		input.close();
 
-		
+		G.compiled = compile(G);
 		return G;
 	}
 	else {
@@ -248,6 +302,22 @@ CFG extractCFG(char* file){
 	}
 }
 
+uint64_t hashCFG(const CFG &G){
+	vector<string> lines;
+	for (auto S : G.starts)
+		lines.push_back("start " + G.nonterminals.name(S));
+	for (auto &p0 : G.vp0)
+		lines.push_back("P0 " + G.nonterminals.name(p0.lhs));
+	for (auto &p1 : G.vp1)
+		lines.push_back("P1 " + G.nonterminals.name(p1.lhs) + "," + G.nonterminals.name(p1.rhs));
+	for (auto &p2 : G.vp2)
+		lines.push_back("P2 " + G.nonterminals.name(p2.lhs) + "," + G.nonterminals.name(p2.rhs1)
+			+ "," + G.nonterminals.name(p2.rhs2));
+	for (auto &pl : G.vpl)
+		lines.push_back("PL " + G.nonterminals.name(pl.lhs) + "," + terminals.name(pl.rhs));
+	return grammarHash(lines);
+}
+
 // prints the current runtime
 void runtime(clock_t t0){
 	cout << "Current time: " << ((float)(clock() - t0) / CLOCKS_PER_SEC) << " seconds" << endl;
@@ -256,65 +326,40 @@ void runtime(clock_t t0){
 // Converts a CFG with contextual rules into a CFG with short strings
 CFG convertCFGC(const CFGC &H){
 	CFG Hprime;
-	unordered_map<contextSet, string> cmap;
-	Hprime.starts.emplace("0");
-	cmap[contextSet()] = "0";
-	unsigned elements = 1;
-
-	for (auto p0c : H.sp0c.set){ // For each P0C rule
-		auto csp = cmap.find(p0c.lhs); // csp = pointer to contextSet
-		if (csp == cmap.end()) // lhs has not been hashed yet
-			cmap.emplace(p0c.lhs, to_string(elements++)); // add it to cmap and increment elements
-		Hprime.vp0.push_back(P0(cmap[p0c.lhs])); // make a new p0 rule and add it to Hprime.vp0
-		// If lhs of rule contains empty context, add sentence rule
-		for (auto c : p0c.lhs.set){  // For each context in p0c.lhs
-			if (c.lhs.size() == 0 && c.rhs.size() == 0)
-				Hprime.vp0.push_back(P0("0"));
-		}
-	}
-	for (auto p1c : H.sp1c.set){
-		
-		auto lhscsp = cmap.find(p1c.lhs);
-		if (lhscsp == cmap.end())
-			cmap.emplace(p1c.lhs, to_string(elements++));
-		auto rhscsp = cmap.find(p1c.rhs);
-		if (rhscsp == cmap.end())
-			cmap.emplace(p1c.rhs, to_string(elements++));
-		Hprime.vp1.push_back(P1(cmap[p1c.lhs], cmap[p1c.rhs])); // make a new P1 rule and add it to Hprime.vp1
-		// If lhs of rule contains empty context, add sentence rule
-		for (auto c : p1c.lhs.set){  // For each context in p0c.lhs
-			if (c.lhs.size() == 0 && c.rhs.size() == 0)
-				Hprime.vp1.push_back(P1("0", cmap[p1c.rhs]));
+	const symbol NONE = ~0u;
+	vector<symbol> cmap(featureSets.size(), NONE);	// context set id -> nonterminal
+	symbol elements = 1;	// 0 is the start symbol
+	Hprime.starts.emplace(0);
+
+	// The nonterminal of context set id, the next free one if it has none yet
+	// If the set holds the empty context, 0 -> it is added the first time
+	auto nonterminal = [&](unsigned int id){
+		symbol &A = cmap[id];
+		if (A == NONE){
+			A = elements++;
+			if (featureSets.hasEmpty(id))
+				Hprime.vp1.push_back(P1(0, A));
 		}
+		return A;
+	};
+	for (auto &p0c : H.sp0c.set)
+		Hprime.vp0.push_back(P0(nonterminal(p0c.lhs)));
+	for (auto &p1c : H.sp1c.set){
+		symbol lhs = nonterminal(p1c.lhs);
+		Hprime.vp1.push_back(P1(lhs, nonterminal(p1c.rhs)));
 	}
-	for (auto p2c : H.sp2c.set){
-		auto lhscsp = cmap.find(p2c.lhs);
-		if (lhscsp == cmap.end())
-			cmap.emplace(p2c.lhs, to_string(elements++));
-		auto rhs1csp = cmap.find(p2c.rhs1);
-		if (rhs1csp == cmap.end())
-			cmap.emplace(p2c.rhs1, to_string(elements++));
-		auto rhs2csp = cmap.find(p2c.rhs2);
-		if (rhs2csp == cmap.end())
-			cmap.emplace(p2c.rhs2, to_string(elements++));
-		Hprime.vp2.push_back(P2(cmap[p2c.lhs], cmap[p2c.rhs1], cmap[p2c.rhs2]));
-		// If lhs of rule contains empty context, add sentence rule
-		for (auto c : p2c.lhs.set){  // For each context in p0c.lhs
-			if (c.lhs.size() == 0 && c.rhs.size() == 0)
-				Hprime.vp2.push_back(P2("0", cmap[p2c.rhs1], cmap[p2c.rhs2]));
-		}
-	}
-	for (auto plc : H.splc.set){
-		auto lhscsp = cmap.find(plc.lhs);
-		if (lhscsp == cmap.end())
-			cmap.emplace(plc.lhs, to_string(elements++));
-		Hprime.vpl.push_back(PL(cmap[plc.lhs], plc.rhs));
-		// If lhs of rule contains empty context, add sentence rule
-		for (auto c : plc.lhs.set){  // For each context in p0c.lhs
-			if (c.lhs.size() == 0 && c.rhs.size() == 0)
-				Hprime.vpl.push_back(PL("0", plc.rhs));
-		}
+	for (auto &p2c : H.sp2c.set){
+		symbol lhs = nonterminal(p2c.lhs);
+		symbol rhs1 = nonterminal(p2c.rhs1);
+		Hprime.vp2.push_back(P2(lhs, rhs1, nonterminal(p2c.rhs2)));
 	}
+	for (auto &plc : H.splc.set)
+		Hprime.vpl.push_back(PL(nonterminal(plc.lhs), plc.rhs));
+
+	// Names are only for printing, so they are made once at the end
+	for (symbol A = 0; A < elements; A++)
+		Hprime.nonterminals.intern(to_string(A));
+	Hprime.compiled = compile(Hprime);
 	return Hprime;
 }
 
@@ -326,13 +371,13 @@ CFG convertCFGC(const CFGC &H){
 void printContext(const context &c){
 	cout << "(";
 	for (unsigned int i = 0; i < c.lhs.size(); i++){
-		cout << c.lhs[i];
+		cout << terminals.name(c.lhs[i]);
 		if (i < c.lhs.size() - 1)
 			cout << " ";
 	}
 	cout << ", ";
 	for (unsigned int i = 0; i < c.rhs.size(); i++){
-		cout << c.rhs[i];
+		cout << terminals.name(c.rhs[i]);
 		if (i < c.rhs.size() - 1)
 			cout << " ";
 	}
@@ -352,7 +397,7 @@ void printContextSet(const unordered_set<context> &S){
 // Print a P0C rule
 void printP0C(const P0C &p0c){
 	cout << "  P0C: ";
-	for (auto c : p0c.lhs.set){
+	for (auto c : featureSets.contexts(p0c.lhs)){
 		printContext(c);
 		cout << " ";
 	}
@@ -369,12 +414,12 @@ void printP0CSet(const P0CSet &sp0c){
 // Print a P1C rule
 void printP1C(const P1C &p1c){
 	cout << "  P1C: ";
-	for (auto c : p1c.lhs.set){
+	for (auto c : featureSets.contexts(p1c.lhs)){
 		printContext(c);
 		cout << " ";
 	}
 	cout << " ->  ";
-	for (auto c : p1c.rhs.set){
+	for (auto c : featureSets.contexts(p1c.rhs)){
 		printContext(c);
 		cout << " ";
 	}
@@ -391,17 +436,17 @@ void printP1CSet(const P1CSet &sp1c){
 // Print a P2C rule
 void printP2C(const P2C &p2c){
 	cout << "  P2C: ";
-	for (auto c : p2c.lhs.set){
+	for (auto c : featureSets.contexts(p2c.lhs)){
 		printContext(c);
 		cout << " ";
 	}
 	cout << " ->  ";
-	for (auto c : p2c.rhs1.set){
+	for (auto c : featureSets.contexts(p2c.rhs1)){
 		printContext(c);
 		cout << " ";
 	}
 	cout << " + ";
-	for (auto c : p2c.rhs2.set){
+	for (auto c : featureSets.contexts(p2c.rhs2)){
 		printContext(c);
 		cout << " ";
 	}
@@ -418,11 +463,11 @@ void printP2CSet(const P2CSet &sp2c){
 // Print a PLC rule
 void printPLC(const PLC &plc){
 	cout << "  PLC: ";
-	for (auto c : plc.lhs.set){
+	for (auto c : featureSets.contexts(plc.lhs)){
 		printContext(c);
 		cout << " ";
 	}
-	cout << " ->  " << plc.rhs << endl;
+	cout << " ->  " << terminals.name(plc.rhs) << endl;
 }
 
 // Print a PLCSet
@@ -433,20 +478,20 @@ void printPLCSet(const PLCSet &splc){
 }
 
 // Print at the beginning of each new sample
-void printProcessing(const vector<string> &w){
+void printProcessing(const vector<symbol> &w){
 	cout << endl << "Processing input: ";
 	for (unsigned int i = 0; i < w.size(); i++)
-		cout << w[i] + " ";
+		cout << terminals.name(w[i]) + " ";
 	cout << endl;
 }
 
 // Print the contents of D
-void printD(const vector<vector<string>> &D){
+void printD(const vector<vector<symbol>> &D){
 	string s = "D: ";
 	for (unsigned int i = 0; i < D.size(); i++){
 		s.append("\"");
 		for (unsigned int j = 0; j < D[i].size(); j++)
-			s.append(D[i][j] + " ");
+			s.append(terminals.name(D[i][j]) + " ");
 		s.pop_back();
 		s.append("\", ");
 	}
@@ -457,12 +502,12 @@ void printD(const vector<vector<string>> &D){
 }
 
 // Print a vector of substrings
-void printSubstringVector(const vector<vector<string>> &s){
+void printSubstringVector(const vector<vector<symbol>> &s){
 	cout << "Substrings: ";
 	for (unsigned int i = 0; i < s.size(); i++){
 		cout << "(";
 		for (unsigned int j = 0; j < s[i].size(); j++){
-			cout << s[i][j];
+			cout << terminals.name(s[i][j]);
 			if (j < s[i].size() - 1)
 				cout << " ";
 		}
@@ -476,29 +521,29 @@ void printCFG(const CFG &G){
 	cout << "Target Grammar:" << endl;
 	cout << "  Start symbols:" << endl;
 	for (auto S : G.starts){
-		cout << "    " << S << endl;
+		cout << "    " << G.nonterminals.name(S) << endl;
 	}
 	cout << "  P0 Rules:" << endl;
 	for (unsigned int i = 0; i < G.vp0.size(); i++){
-		cout << "    " << G.vp0[i].lhs << " -> e" << endl;
+		cout << "    " << G.nonterminals.name(G.vp0[i].lhs) << " -> e" << endl;
 	}
 	cout << "  P1 Rules:" << endl;
 	for (unsigned int i = 0; i < G.vp1.size(); i++){
-		cout << "    " << G.vp1[i].lhs << " -> " << G.vp1[i].rhs << endl;
+		cout << "    " << G.nonterminals.name(G.vp1[i].lhs) << " -> " << G.nonterminals.name(G.vp1[i].rhs) << endl;
 	}
 	cout << "  P2 Rules:" << endl;
 	for (unsigned int i = 0; i < G.vp2.size(); i++){
-		cout << "    " << G.vp2[i].lhs << " ->";
-		cout << " " << G.vp2[i].rhs1 << "," << G.vp2[i].rhs2 << endl;
+		cout << "    " << G.nonterminals.name(G.vp2[i].lhs) << " ->";
+		cout << " " << G.nonterminals.name(G.vp2[i].rhs1) << "," << G.nonterminals.name(G.vp2[i].rhs2) << endl;
 	}
 	cout << "  PL Rules:" << endl;
 	for (unsigned int i = 0; i < G.vpl.size(); i++)
-		cout << "    " << G.vpl[i].lhs << " -> " << G.vpl[i].rhs << endl;
+		cout << "    " << G.nonterminals.name(G.vpl[i].lhs) << " -> " << terminals.name(G.vpl[i].rhs) << endl;
 	cout << "  Samples:" << endl;
 	for (auto S : G.samples){
 		cout << "    ";
 		for (unsigned int j = 0; j < S.size(); j++)
-			cout << S[j] << " ";
+			cout << terminals.name(S[j]) << " ";
 		cout << endl;
 	}
 	cout << endl;
@@ -17,14 +17,19 @@
 #ifndef _TYPES_
 #define _TYPES_
 
+#include <atomic>
 #include <fstream>
 #include <iomanip>
+#include <memory>
 #include <string>
 #include <time.h>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
+#include "bitset.h"
+#include "symbols.h"
+
 using namespace::std;
 ////////////////////////////////////////////////////////////////
 /* CFG types                                                  */
@@ -33,48 +38,152 @@ using namespace::std;
 // P0 CFG Rule
 struct P0{
 	P0() {}
-	P0(string s)
+	P0(symbol s)
 		: lhs(s) {}
-	string lhs;
+	symbol lhs;
 };
 
 // P1 CFG Rule
 struct P1{
 	P1() {}
-	P1(string l, string r)
+	P1(symbol l, symbol r)
 		: lhs(l), rhs(r) {}
-	string lhs;
-	string rhs;
+	symbol lhs;
+	symbol rhs;
 };
 
 // P2 CFG Rule
 struct P2{
 	P2() {}
-	P2(string l, string r1, string r2)
+	P2(symbol l, symbol r1, symbol r2)
 		: lhs(l), rhs1(r1), rhs2(r2) {}
-	string lhs;
-	string rhs1;
-	string rhs2;
+	symbol lhs;
+	symbol rhs1;
+	symbol rhs2;
 };
 
 // PL CFG Rule
 struct PL{
 	PL() {}
-	PL(string l, string r)
+	PL(symbol l, symbol r)
 		: lhs(l), rhs(r) {}
-	string lhs;
-	string rhs;
+	symbol lhs;	// nonterminal
+	symbol rhs;	// terminal
+};
+
+// One (C, {A}) entry of the binary rules A -> B C that share a left child B
+struct BinaryEntry{
+	BinaryEntry() {}
+	BinaryEntry(symbol r, unsigned int p)
+		: right(r), parents(p) {}
+	symbol right;		// C
+	unsigned int parents;	// offset of the {A} bitset in GrammarIndex::parentSets
+};
+
+// A run of T kept alive by something else: a vector, or a file mapped into memory
+template <class T>
+struct Span{
+	Span() : first(NULL), count(0) {}
+	Span(const T* p, size_t n) : first(p), count(n) {}
+	Span(const vector<T> &v) : first(v.data()), count(v.size()) {}
+	const T* data() const { return first; }
+	size_t size() const { return count; }
+	const T &operator[](size_t i) const { return first[i]; }
+	const T* begin() const { return first; }
+	const T* end() const { return first + count; }
+	const T* first;
+	size_t count;
+};
+
+// One slot of GrammarIndex::pairs, an open addressing table over (B, C) pairs
+// The layout is the same in memory and in a binary grammar file
+struct PairSlot{
+	PairSlot() {}
+	PairSlot(uint64_t k, unsigned int p)
+		: key(k), parents(p), unused(0) {}
+	uint64_t key;		// B << 32 | C, or EMPTY_PAIR
+	unsigned int parents;	// offset of the {A} bitset in GrammarIndex::parentSets
+	unsigned int unused;
+};
+const uint64_t EMPTY_PAIR = ~(uint64_t)0;
+
+// Slot a probe for key starts at, in a table of mask + 1 slots
+inline size_t pairSlot(uint64_t key, size_t mask){
+	return (size_t)((key * 0x9e3779b97f4a7c15ULL) >> 32) & mask;
+}
+
+// The arrays of a GrammarIndex made by compile(), which its copies share
+struct GrammarTables{
+	vector<unsigned int> lexicon;
+	vector<word> lexicalSets;
+	vector<PairSlot> pairs;
+	vector<unsigned int> firstEntry;
+	vector<BinaryEntry> entries;
+	vector<word> parentSets;
+};
+
+// Lookup tables over a CFG so the CYK engine only touches the rules that can fire
+// Every {A} set is already closed under chains.  The arrays point into storage, which
+// copies of the index share: the GrammarTables it was built in, or the binary grammar
+// file it was mapped from (see grammarfile.h)
+struct GrammarIndex{
+	GrammarIndex() : nonterminals(0), ntWords(0) {}
+	const word* lexical(symbol a) const;		// {A | A =>* a}, NULL if there is none
+	const word* parents(symbol B, symbol C) const;	// {A | A =>* B C}, NULL if there is none
+	Span<BinaryEntry> byLeft(symbol B) const {	// every (C, {A}) with A =>* B C
+		return Span<BinaryEntry>(entries.data() + firstEntry[B], firstEntry[B + 1] - firstEntry[B]);
+	}
+	void use(const shared_ptr<const GrammarTables> &tables);	// points every array into tables
+	unsigned int nonterminals;	// nonterminal ids are 0 .. nonterminals-1
+	unsigned int ntWords;		// words in a bitset over nonterminals
+	Span<unsigned int> lexicon;	// terminal a -> offset of {A | A =>* a}, NONE if a has no rule
+	Span<word> lexicalSets;		// those {A} bitsets, ntWords words each, shared by equal sets
+	Span<PairSlot> pairs;		// (B, C) -> offset of {A | A =>* B C}, a power of two slots at most half full
+	Span<unsigned int> firstEntry;	// B -> B's first entry, then one past the last B's last
+	Span<BinaryEntry> entries;	// every (C, {A}) with A =>* B C, grouped by B
+	Span<word> parentSets;		// the {A} bitsets, ntWords words each
+	shared_ptr<const void> storage;	// what the arrays point into
+	static const unsigned int NONE = ~0u;
+};
+
+// Everything the recognizers need from a CFG, worked out once by compile() (cyke.h)
+// nullable and every row of chains are bitsets over nonterminals, ntWords words each
+// Every new CompiledGrammar gets a version of its own, and copies keep it, so a
+// recognizer built from one can tell when the grammar it was given is another
+extern atomic<unsigned long long> compiledVersions;
+struct CompiledGrammar{
+	CompiledGrammar() : nonterminals(0), ntWords(0), version(++compiledVersions) {}
+	const word* chain(symbol x) const { return &chains[x * ntWords]; }	// {C | C =>* x}
+	unsigned int nonterminals;	// nonterminal ids are 0 .. nonterminals-1
+	unsigned int ntWords;
+	unsigned long long version;
+	vector<word> nullable;		// {A | A =>* λ}
+	vector<word> chains;		// row x is {C | C =>* x}, with x itself
+	GrammarIndex index;		// lexicon and binary rules, closed under chains
 };
 
 // A CFG
+// Nonterminal ids are local to each grammar, terminal ids come from the global table
+// compiled must be filled in with compile() after the rules are final (extractCFG and
+// convertCFGC do it)
 struct CFG{
 	vector<P0> vp0;
 	vector<P1> vp1;
 	vector<P2> vp2;
 	vector<PL> vpl;
-	unordered_set<string> starts;
-	vector<vector<string>> samples;
-	unordered_map<string, unordered_set<string>> chains;
+	unordered_set<symbol> starts;
+	vector<vector<symbol>> samples;
+	CompiledGrammar compiled;
+	SymbolTable nonterminals;
+};
+
+// Weights of a CFG's rules, in the order of its rule vectors
+// A rule is picked in proportion to its weight among the rules with its left side
+struct RuleWeights{
+	vector<double> p0;
+	vector<double> p1;
+	vector<double> p2;
+	vector<double> pl;
 };
 
 ////////////////////////////////////////////////////////////////
@@ -86,13 +195,20 @@ struct CFG{
  * - Struct of set<type> (necessary abstraction) */
 
 // A single context
+// The hash is worked out once, when the context is made, so lhs and rhs
+// must not be changed afterwards
 struct context{
-	context(){ lhs.resize(0); rhs.resize(0); }
-	vector<string> lhs;
-	vector<string> rhs;
+	context(){ rehash(); }
+	context(const vector<symbol> &l, const vector<symbol> &r)
+		: lhs(l), rhs(r) { rehash(); }
+	vector<symbol> lhs;
+	vector<symbol> rhs;
+	size_t hash;
 	bool operator==(const context &other) const {
-		return (lhs == other.lhs && rhs == other.rhs);
+		return (hash == other.hash && lhs == other.lhs && rhs == other.rhs);
 	}
+private:
+	void rehash();
 };
 
 // context hash definition (for stl sets)
@@ -100,24 +216,22 @@ namespace std {
 	template <>	struct hash <context>
 	{
 		size_t operator()(const context &c) const {
-			string lhs, rhs;
-			for (auto s : c.lhs)
-				lhs += s;
-			for (auto s : c.rhs)
-				rhs += s;
-			return (hash<string>()(lhs) ^ (hash<string>()(rhs)));
+			return c.hash;
 		}
 	};
 }
 
 // context unordered_set (link struct)
+// Contexts are added with add(), which keeps hash up to date.  hash is the sum of
+// the mixed context hashes, so it doesn't depend on the order of the set
 struct contextSet{
-	contextSet(){
-		set = unordered_set<context>();
-	}
+	contextSet()
+		: hash(0) {}
 	unordered_set<context> set;
+	size_t hash;
+	void add(const context &c);
 	bool operator==(const contextSet &other) const {
-		return set == other.set;
+		return (hash == other.hash && set == other.set);
 	}
 };
 
@@ -126,23 +240,17 @@ namespace std {
 	template <>	struct hash <contextSet>
 	{
 		size_t operator()(const contextSet &s) const {
-			string lhs, rhs;
-			for (auto c : s.set){
-				for (auto s : c.lhs)
-					lhs += s;
-				for (auto s : c.rhs)
-					rhs += s;
-			}
-			return (hash<string>()(lhs) ^ (hash<string>()(rhs)));
+			return s.hash;
 		}
 	};
 }
 ////////////////////////////////////////////////////////////////
 // P0C Rule
+// Context sets are ids in featureSets (see featuresets.h)
 struct P0C{
-	P0C(contextSet a)
+	P0C(unsigned int a)
 		: lhs(a) {}
-	contextSet lhs;
+	unsigned int lhs;
 	bool operator==(const P0C &other) const {
 		return (lhs == other.lhs);
 	}
@@ -152,12 +260,7 @@ struct P0C{
 namespace std {
 	template <>	struct hash <P0C>
 	{
-		size_t operator()(const P0C &p0c) const {
-			string lhs;
-			if (p0c.lhs.set.begin()->lhs.size() > 0)
-				lhs = p0c.lhs.set.begin()->lhs[0];
-			return (hash<string>()(lhs) ^ p0c.lhs.set.begin()->lhs.size());
-		}
+		size_t operator()(const P0C &p0c) const;
 	};
 }
 
@@ -171,10 +274,10 @@ struct P0CSet{
 ////////////////////////////////////////////////////////////////
 // P1C Rule
 struct P1C{
-	P1C(contextSet a, contextSet b)
+	P1C(unsigned int a, unsigned int b)
 		: lhs(a), rhs(b) {}
-	contextSet lhs;
-	contextSet rhs;
+	unsigned int lhs;
+	unsigned int rhs;
 	bool operator==(const P1C &other) const {
 		return (lhs == other.lhs && rhs == other.rhs);
 	}
@@ -184,14 +287,7 @@ struct P1C{
 namespace std {
 	template <>	struct hash <P1C>
 	{
-		size_t operator()(const P1C &p1c) const {
-			string lhs, rhs;
-			if (p1c.lhs.set.begin()->lhs.size() > 0)
-				lhs = p1c.lhs.set.begin()->lhs[0];
-			if (p1c.rhs.set.begin()->lhs.size() > 0)
-				rhs = p1c.rhs.set.begin()->lhs[0];
-			return (hash<string>()(lhs) ^ (hash<string>()(rhs)) ^ p1c.lhs.set.begin()->lhs.size());
-		}
+		size_t operator()(const P1C &p1c) const;
 	};
 }
 
@@ -205,11 +301,11 @@ struct P1CSet{
 ////////////////////////////////////////////////////////////////
 // P2 Contextual Rule
 struct P2C{
-	P2C(contextSet a, contextSet b, contextSet c)
+	P2C(unsigned int a, unsigned int b, unsigned int c)
 		:lhs(a), rhs1(b), rhs2(c) {}
-	contextSet lhs;
-	contextSet rhs1;
-	contextSet rhs2;
+	unsigned int lhs;
+	unsigned int rhs1;
+	unsigned int rhs2;
 	bool operator==(const P2C &other) const {
 		return (lhs == other.lhs && rhs1 == other.rhs1 && rhs2 == other.rhs2);
 	}
@@ -219,16 +315,7 @@ struct P2C{
 namespace std {
 	template <>	struct hash <P2C>
 	{
-		size_t operator()(const P2C &p2c) const {
-			string lhs, rhs1, rhs2;
-			if (p2c.lhs.set.begin()->lhs.size() > 0)
-				lhs = p2c.lhs.set.begin()->lhs[0];
-			if (p2c.rhs1.set.begin()->lhs.size() > 0)
-				rhs1 = p2c.rhs1.set.begin()->lhs[0];
-			if (p2c.rhs2.set.begin()->lhs.size() > 0)
-				rhs2 = p2c.rhs2.set.begin()->lhs[0];
-			return (hash<string>()(lhs) ^ ((hash<string>()(rhs1) << 1) ^ (hash<string>()(rhs2)) << 1));
-		}
+		size_t operator()(const P2C &p2c) const;
 	};
 }
 
@@ -242,10 +329,10 @@ struct P2CSet{
 ////////////////////////////////////////////////////////////////
 // PL Contextual Rule
 struct PLC{
-	PLC(contextSet a, string b)
+	PLC(unsigned int a, symbol b)
 		: lhs(a), rhs(b) {}
-	contextSet lhs;
-	string rhs;
+	unsigned int lhs;
+	symbol rhs;
 	bool operator==(const PLC &other) const {
 		return (lhs == other.lhs && rhs == other.rhs);
 	}
@@ -255,12 +342,7 @@ struct PLC{
 namespace std {
 	template <>	struct hash <PLC>
 	{
-		size_t operator()(const PLC &plc) const {
-			string lhs;
-			if (plc.lhs.set.begin()->lhs.size() > 0)
-				lhs = plc.lhs.set.begin()->lhs[0];
-			return (hash<string>()(lhs) ^ (hash<string>()(plc.rhs) << 1));
-		}
+		size_t operator()(const PLC &plc) const;
 	};
 }
 
@@ -287,8 +369,8 @@ struct CFGC{
 // Check if two contexts are equal
 bool equal(context a, context);
 
-// Check if two string vectors are equal
-bool equal(vector<string> a, vector<string> b);
+// Check if two symbol vectors are equal
+bool equal(vector<symbol> a, vector<symbol> b);
 
 // Check if two context vectors are equal
 bool equal(vector<context> a, vector<context> b);
@@ -297,8 +379,8 @@ bool equal(vector<context> a, vector<context> b);
 /* Vector search utility functions                            */
 ////////////////////////////////////////////////////////////////
 
-// Search for a string w in vector v
-bool search(vector<string> v, string w);
+// Search for a symbol w in vector v
+bool search(vector<symbol> v, symbol w);
 
 // Search for a context c in vector v
 bool search(vector<context> v, context c);
@@ -307,7 +389,7 @@ bool search(vector<context> v, context c);
 bool search(vector<vector<context>> v2, context c);
 
 // Search for a subset string in a list of subsets
-bool search(vector<vector<string>> v, vector<string> s);
+bool search(vector<vector<symbol>> v, vector<symbol> s);
 
 ////////////////////////////////////////////////////////////////
 /* Subset utility functions                                   */
@@ -323,13 +405,21 @@ bool subset(vector<context> c1, vector<vector<context>> cl);
 /* Utility Functions                                          */
 ////////////////////////////////////////////////////////////////
 
-// Takes the input file and creates an CFG object for the target grammar
-CFG extractCFG(char* file);
+// Takes the input file and creates an CFG object for the target grammar, compiled
+// The file may be text or a binary grammar written by writeBinaryGrammar
+// A rule may end with one more symbol, its weight (A -> a 0.25, S -> A,B 0.5 or
+// A -> 0.1 for an empty rule), which only goes into weights.  A rule without one
+// weighs 1, as does every rule of a binary grammar.
+CFG extractCFG(char* file, RuleWeights* weights = NULL);
+
+// Hash of a CFG's rules and start symbols (samples don't count)
+uint64_t hashCFG(const CFG &G);
 
 // prints the current runtime
 void runtime(clock_t t0);
 
-// Converts a CFG with contextual rules into a CFG with short strings
+// Converts a CFG with contextual rules into a compiled CFG, with a nonterminal for
+// every context set and start symbol 0.  0 -> A for each A whose set has (λ, λ).
 CFG convertCFGC(const CFGC &H);
 
 ////////////////////////////////////////////////////////////////
@@ -367,13 +457,13 @@ void printPLC(const PLC &plc);
 void printPLCSet(const PLCSet &splc);
 
 // Print at the beginning of each new sample
-void printProcessing(const vector<string> &w);
+void printProcessing(const vector<symbol> &w);
 
 // Print the contents of D
-void printD(const vector<vector<string>> &D);
+void printD(const vector<vector<symbol>> &D);
 
 // Print a vector of substrings
-void printSubstringVector(const vector<vector<string>> &s);
+void printSubstringVector(const vector<vector<symbol>> &s);
 
 // Print a CFG
 void printCFG(const CFG &G);
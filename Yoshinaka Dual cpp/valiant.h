@@ -0,0 +1,47 @@
+/****************************************************************
+ * File: valiant.h
+ * Sub-cubic recognizer: CYK closure by boolean matrix multiplication
+ ****************************************************************/
+#ifndef _VALIANT_
+#define _VALIANT_
+
+#include <vector>
+
+#include "bitset.h"
+#include "types.h"
+
+// Recognizer that reduces the CYK closure to boolean matrix multiplication
+// (Valiant 1975, in the divide and conquer form of Okhotin 2014)
+//
+// Positions 0..N-1 (N = the next power of two above n) index an N x N matrix per
+// nonterminal X with T_X[i][j] = 1 iff X derives w[i..j).  For every (B, C) in the
+// grammar index, P_BC[i][j] = 1 iff some split k has B in T[i][k] and C in T[k][j].
+// The upper triangle is filled block by block, and all of the split points between
+// two blocks are added at once by multiplying bit matrices.
+class ValiantRecognizer{
+public:
+	ValiantRecognizer(const GrammarIndex &index);
+	// Fills top with the nonterminals that derive all of w (w must not be empty)
+	void parse(const vector<symbol> &w, vector<word> &top);
+private:
+	const GrammarIndex &index;
+	struct Pair{
+		symbol left;
+		symbol right;
+		unsigned int parents;	// offset of {A | A =>* left right} in index.parentSets
+	};
+	vector<Pair> pairs;		// grouped by left child
+	unsigned int N;			// matrix size (a power of two)
+	unsigned int R;			// words per matrix row
+	vector<word> T;			// one N x N matrix per nonterminal
+	vector<word> P;			// one N x N matrix per pair
+
+	word* Trow(symbol X, unsigned int i){ return &T[((size_t)X * N + i) * R]; }
+	word* Prow(unsigned int p, unsigned int i){ return &P[((size_t)p * N + i) * R]; }
+	void multiply(unsigned int r0, unsigned int r1, unsigned int k0, unsigned int k1,
+		unsigned int c0, unsigned int c1);
+	void compute(unsigned int l, unsigned int m);
+	void complete(unsigned int l, unsigned int m, unsigned int l2, unsigned int m2);
+};
+
+#endif
@@ -7,288 +7,216 @@
  * command line argument
  ****************************************************************/
 #include <cctype>
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
 #include <string>
 #include <time.h>
 #include <vector>
 
+#include "checkpoint.h"
 #include "cyke.h"
+#include "grammarfile.h"
+#include "learner.h"
+#include "samplereader.h"
 #include "types.h"
 
 using namespace::std;
 
-////////////////////////////////////////////////////////////////
-/* Yoshinaka algorithm                                        */
-////////////////////////////////////////////////////////////////
-
-// Just like python version
-void addSub(vector<vector<string>> &SubD, const vector<string> w){
-	for (unsigned int i = 0; i < w.size(); i++){
-		for (unsigned int j = i; j <= w.size(); j++){
-			vector<string> temp;
-			for (unsigned int k = i; k < j; k++) // Python: s=w[i:j]
-				temp.push_back(w[k]);
-
-			if (!search(SubD, temp)) // If temp is not already in ConD, add it
-				SubD.push_back(temp);
-		}
+// Main Algorithm function
+// The target's own samples are learned first, then those of stream if there is one.
+// Streamed samples the target rejects are skipped, and queries are answered with
+// the hypothesis as it is at that point.
+// With a checkpoint file, the state is saved there every `every` learned samples and
+// at the end.  A run resumed from a checkpoint skips the samples and stream lines
+// it had already read.
+CFGC fFCP(const CFG &target, const int f, const bool closed, SampleReader* stream,
+	const Checkpoint* resume, const string &checkpoint, unsigned int every){
+	clock_t t0 = clock();
+	DualLearner learner(target, f, closed);
+	uint64_t targetSamples = 0;	// target samples learned
+	uint64_t streamLines = 0;	// stream lines read before the checkpoint
+	unsigned int unsaved = 0;	// samples learned since the last checkpoint
+	if (resume){
+		learner.restore(*resume);
+		targetSamples = resume->targetSamples;
+		streamLines = resume->streamLines;
 	}
-}
 
-// Just like python vesion
-void addCon(contextSet &ConD, const vector<string> w){
-	for (unsigned int i = 0; i <= w.size(); i++){
-		for (unsigned int j = i; j <= w.size() + 1; j++){
-			context c;
-			for (unsigned int k = 0; k < i; k++)
-				c.lhs.push_back(w[k]);
-			for (unsigned int k = j; k < w.size(); k++)
-				c.rhs.push_back(w[k]);
-			ConD.set.emplace(c);
-		}
+	auto save = [&](){
+		if (checkpoint.empty())
+			return;
+		Checkpoint c = learner.state();
+		c.grammar = hashCFG(target);
+		c.targetSamples = targetSamples;
+		c.streamLines = stream ? stream->lineCount() : 0;
+		historyG.store.flush();
+		if (!writeCheckpoint(checkpoint, c))
+			cout << "Unable to write checkpoint " << checkpoint << endl;
+		unsaved = 0;
+	};
+	auto learn = [&](const vector<symbol> &w){
+		printProcessing(w);
+		runtime(t0);
+		learner.learn(w);
+		if (++unsaved >= every)
+			save();
+	};
+	while (targetSamples < target.samples.size()){
+		targetSamples++;
+		learn(target.samples[targetSamples - 1]);
 	}
-}
 
-// CK - just like python
-vector<vector<string>> CK(const contextSet C, const vector<vector<string>> K, const CFG &G){
-	vector<vector<string>> ck;
-	for (auto w : K){
-		bool b = true;
-		for (auto c : C.set){
-			vector<string> lur;
-			for (auto s : c.lhs)
-				lur.push_back(s);
-			for (auto s : w)
-				lur.push_back(s);
-			for (auto s : c.rhs)
-				lur.push_back(s);
-			if (!accepts(lur, G, G.chains, historyG)){
-				b = false;
-				break;
+	vector<symbol> w;
+	bool query;
+	while (stream && stream->lineCount() < streamLines && stream->next(w, query))
+		;	// read before the checkpoint was saved
+	// Answers of the hypothesis, kept until it is compiled again, so queries repeated
+	// between two samples are answered from here
+	History hypothesisHistory;
+	unsigned long long hypothesisVersion = 0;
+	while (stream && stream->next(w, query)){
+		if (query){
+			const CFG &Hprime = learner.hypothesis();
+			if (Hprime.compiled.version != hypothesisVersion){
+				hypothesisHistory.clear();
+				hypothesisHistory.prefix.clear();
+				hypothesisVersion = Hprime.compiled.version;
 			}
+			cout << (accepts(w, Hprime, Hprime.compiled, hypothesisHistory) ? "Hypothesis accepts:" : "Hypothesis rejects:");
+			for (auto s : w)
+				cout << " " << terminals.name(s);
+			cout << endl;
 		}
-		if (b){
-			ck.push_back(w);
+		else if (!accepts(w, target, target.compiled, historyG)){
+			cout << "Skipping sample rejected by target grammar:";
+			for (auto s : w)
+				cout << " " << terminals.name(s);
+			cout << endl;
 		}
+		else
+			learn(w);
 	}
-	return ck;
-}
 
-void newP0C(const contextSet C, P0CSet &sp0c, const CFG &G){
-	for (auto c : C.set){
-		vector<string> lur;
-		for (auto s : c.lhs)
-			lur.push_back(s);
-		for (auto s : c.rhs)
-			lur.push_back(s);
-		if (!accepts(lur, G, G.chains, historyG))
-			return;
-	}
-	P0C p0c(C);
-	sp0c.set.emplace(p0c);
-}
+	save();
+	cout << endl << "Done. Checking learner grammar..." << endl;
+	runtime(t0);
+	History h;
+	checkLearner(learner.hypothesis(), h, learner.samples());
+	runtime(t0);
 
-void newP2C(const contextSet C, const unordered_set<contextSet> Vf,
-	const vector<vector<string>> K, P2CSet &sp2c, const CFG &G){
-	for (auto C1 : Vf){
-		for (auto C2 : Vf){
-			vector<vector<string>> ck1 = CK(C1, K, G);
-			vector<vector<string>> ck2 = CK(C2, K, G);
-			bool b = true;
-			for (auto c : C.set){
-				for (auto s1 : ck1){
-					for (auto s2 : ck2){
-						vector<string> lur;
-						for (auto s : c.lhs)
-							lur.push_back(s);
-						for (auto s : s1)
-							lur.push_back(s);
-						for (auto s : s2)
-							lur.push_back(s);
-						for (auto s : c.rhs)
-							lur.push_back(s);
-						if (!accepts(lur, G, G.chains, historyG)){
-							b = false;
-							break;
-						}
-					}
-					if (!b)
-						break;
-				}
-				if (!b)
-					break;
-			}
-			if (b){
-				P2C p2c(C, C1, C2);
-				sp2c.set.emplace(p2c);
-			}
-		}
-	}
+	return learner.rules();
 }
 
-void newPLC(const contextSet C, PLCSet &splc, const CFG &G, unordered_set<string> sigma){
-	for (auto x : sigma){
-		bool b = true;
-		for (auto c : C.set){
-			vector<string> lur;
-			for (auto s : c.lhs)
-				lur.push_back(s);
-			lur.push_back(x);
-			for (auto s : c.rhs)
-				lur.push_back(s);
-			if (!accepts(lur, G, G.chains, historyG)){
-				b = false;
-				break;
+// yoshinakadual grammar.txt [--cache dir] [--cache-limit mb] [-f n] [--closed]
+//	[--stream file] [--checkpoint file] [--checkpoint-every n] [--resume file]
+// yoshinakadual grammar.txt --write-binary grammar.bin
+// The grammar may be text or binary; --write-binary only converts it to binary
+// With --cache, oracle answers are read from and added to a file in dir shared by
+// every run on the same target grammar
+// --cache-limit sets the megabytes the oracle's history of answers may take in memory
+// (256 by default); past it the answers least recently used are dropped
+// With --stream, more samples are read from file (- for stdin) one line at a time
+// after the grammar's own, and learned as they come (see SampleReader)
+// -f sets the most contexts a nonterminal may have (1 by default), and --closed makes
+// the nonterminals the closures of those sets instead (see closedVf)
+// With --checkpoint, the learner's state is saved to file every n learned samples (10 by
+// default) and at the end, and the oracle's answers are added to file.answers as they
+// are made (to the cache instead, with --cache).  --resume starts from the
+// state saved in file, given the same grammar, stream, -f and --closed, and goes on
+// saving to it.  If file doesn't exist yet the run starts from the beginning, so a
+// job that may be stopped can always be started with --resume.
+int main(int argc, char* argv[]){
+	CFG target = extractCFG(argv[1]);
+	int f = 1;
+	bool closed = false;
+	SampleReader* stream = NULL;
+	Checkpoint* resume = NULL;
+	string checkpoint;
+	unsigned int every = 10;
+	for (int i = 2; i < argc; i++)
+		if (string(argv[i]) == "--closed")
+			closed = true;
+		else if (string(argv[i]) == "--write-binary" && i + 1 < argc){
+			if (!writeBinaryGrammar(argv[i + 1], target)){
+				cout << "Unable to write " << argv[i + 1] << endl;
+				exit(1);
 			}
+			cout << "Wrote " << argv[i + 1] << endl;
+			return 0;
 		}
-		if (b){
-			PLC plc(C, x);
-			splc.set.emplace(plc);
-		}
-	}
-}
-
-void newP1C(const P0CSet &sp0c, P1CSet &sp1c, const P2CSet &sp2c,
-	const PLCSet &splc, const CFG &G)
-{
-	context c = context();
-	contextSet cs;
-	cs.set.emplace(c);
-	for (auto r : sp0c.set){ // For each P0C rule
-		if (r.lhs.set.find(c) != r.lhs.set.end()){
-			P1C p1c(cs, r.lhs);
-			sp1c.set.emplace(p1c);
-		}
-	}
-	for (auto r : sp2c.set){ // For each P2C rule
-		if (r.lhs.set.find(c) != r.lhs.set.end()){
-			P1C p1c(cs, r.lhs);
-			sp1c.set.emplace(p1c);
-		}
-	}
-	for (auto r : splc.set){ // For each PLC rule
-		if (r.lhs.set.find(c) != r.lhs.set.end()){
-			P1C p1c(cs, r.lhs);
-			sp1c.set.emplace(p1c);
+		else if (string(argv[i]) == "--cache-limit" && i + 1 < argc){
+			int mb = atoi(argv[i + 1]);
+			if (mb < 1){
+				cout << "--cache-limit must be a number of at least 1" << endl;
+				exit(1);
+			}
+			historyG.setLimit((size_t)mb << 20);
 		}
-	}
-}
-
-// Return the powerset of a set of contexts F
-unordered_set<contextSet> powerSet(contextSet F, int f){
-	unordered_set<contextSet> a;
-	if (f > 0) // Recursive case
-	{
-		auto b = powerSet(F, f - 1);
-		for (auto cset : b){
-			for (auto c : F.set){
-				cset.set.emplace(c);
-				a.emplace(cset);
+	for (int i = 2; i + 1 < argc; i++)
+		if (string(argv[i]) == "-f"){
+			f = atoi(argv[i + 1]);
+			if (f < 1){
+				cout << "-f must be a number of at least 1" << endl;
+				exit(1);
 			}
 		}
-		for (auto c : F.set){
-			contextSet cset;
-			cset.set.emplace(c);
-			a.emplace(cset);
+		else if (string(argv[i]) == "--cache"){
+			if (historyG.store.open(argv[i + 1], hashCFG(target), historyG))
+				cout << "Loaded " << historyG.store.loaded() << " answers from "
+					<< historyG.store.path() << endl << endl;
+			else
+				cout << "Can't use the cache in " << argv[i + 1] << endl << endl;
 		}
-	}
-	return a; // Base case or recursive step finished
-}
-
-// Create a Conditional CFG Grammar from F and K
-CFGC Hf(const contextSet &F, const vector<vector<string>> &K,
-	const CFG &G, const unordered_set<string> &sigma, const int f)
-{
-	// printContextSet(F.set);
-	// printD(K);
-	CFGC H;
-	unordered_set<contextSet> Vf = powerSet(F,f);
-	//for (auto cs : Vf)
-	//	printContextSet(cs.set);
-	for (auto Cset : Vf){ // Cset is a set of contexts
-		if (Cset.set.size() > 0){
-			newP0C(Cset, H.sp0c, G);
-			newP2C(Cset, Vf, K, H.sp2c, G);
-			newPLC(Cset, H.splc, G, sigma);
+		else if (string(argv[i]) == "--stream"){
+			stream = new SampleReader(argv[i + 1]);
+			if (!stream->isOpen()){
+				cout << "Unable to open " << argv[i + 1] << endl;
+				exit(1);
+			}
 		}
-	}
-	newP1C(H.sp0c, H.sp1c, H.sp2c, H.splc, G);
-	// printCFGC(H);
-	return H;
-}
-
-
-bool notInLhat(vector<vector<string>> D, CFG &Hprime, History &history){
-	//if (Hprime.vp0.size() + Hprime.vp1.size() + Hprime.vp2.size()
-	//	+ Hprime.vpl.size() == 0) // If Hprime is empty, just return true
-	//	return true;
-	for (auto s : D){
-		// printCFG(Hprime);
-		if (!accepts(s, Hprime, history)){
-			cout << "Not in Lhat" << endl;
-			return true;
+		else if (string(argv[i]) == "--checkpoint")
+			checkpoint = argv[i + 1];
+		else if (string(argv[i]) == "--checkpoint-every")
+			every = max(atoi(argv[i + 1]), 1);
+		else if (string(argv[i]) == "--resume"){
+			if (checkpoint.empty())
+				checkpoint = argv[i + 1];
+			if (!ifstream(argv[i + 1]).is_open()){
+				cout << "No checkpoint in " << argv[i + 1] << " yet, starting from the first sample" << endl << endl;
+				continue;
+			}
+			resume = new Checkpoint();
+			if (!readCheckpoint(argv[i + 1], *resume)){
+				cout << "Unable to resume from " << argv[i + 1] << endl;
+				exit(1);
+			}
+			if (resume->grammar != hashCFG(target)){
+				cout << argv[i + 1] << " was saved from another grammar" << endl;
+				exit(1);
+			}
+			cout << "Resuming after " << resume->D.size() << " samples from " << argv[i + 1] << endl << endl;
 		}
+	if (resume && (resume->f != f || resume->closed != closed)){
+		cout << "The checkpoint was saved with -f " << resume->f << (resume->closed ? " --closed" : "") << endl;
+		exit(1);
 	}
-	cout << "In Lhat" << endl;
-	return false;
-}
-
-// Main Algorithm function
-CFGC fFCP(const CFG &target, const int f){
-	clock_t t0 = clock();
-
-	vector<vector<string>> D;
-	vector<vector<string>> SubD;
-	vector<vector<string>> K;
-	contextSet F;
-	contextSet ConD;
-	unordered_set<string> sigma;
-
-	for (auto pl : target.vpl)
-		sigma.emplace(pl.rhs);
-
-	CFGC Hhat = Hf(F, K, target, sigma, f);
-	CFG Hprime;
-
-	for (unsigned int i = 0; i < target.samples.size(); i++){
-		vector<string> w = target.samples[i];
-		printProcessing(w);
-		runtime(t0);
-		D.push_back(w);
-		// printD(D);
-		addCon(ConD, w);
-		// printContextSet(ConD.set);
-		addSub(SubD, w);
-		// printSubstringVector(SubD);
-		K = SubD;
-		Hhat = Hf(F, K, target, sigma, f);
-		Hprime = convertCFGC(Hhat);
-		History h;
-		if (notInLhat(D, Hprime, h)){
-			for (auto c : ConD.set)
-				F.set.emplace(c);
-			Hhat = Hf(F, K, target, sigma, f);
-			Hprime = convertCFGC(Hhat);
-		}
-
-		// printCFGC(Hhat);
-		// printCFG(Hprime);
+	if (!checkpoint.empty() && !historyG.store.isOpen()){
+		if (!historyG.store.openFile(checkpoint + ".answers", hashCFG(target), historyG))
+			cout << "Can't keep the oracle's answers in " << checkpoint << ".answers" << endl << endl;
+		else if (historyG.store.loaded() > 0)
+			cout << "Loaded " << historyG.store.loaded() << " answers from "
+				<< historyG.store.path() << endl << endl;
 	}
-	cout << endl << "Done. Checking learner grammar..." << endl;
-	runtime(t0);
-	History h;
-	checkLearner(Hprime, h, target.samples);
-	runtime(t0);
-
-	return Hhat;
-}
-
-int main(int argc, char* argv[]){
-	CFG target = extractCFG(argv[1]);
 	printCFG(target);
 	checkSamples(target);
-	CFGC Hhat = fFCP(target, 1);
+	CFGC Hhat = fFCP(target, f, closed, stream, resume, checkpoint, every);
 	cout << endl << "Learner's grammar:" << endl;
 	// printCFGC(Hhat);
 	printCFGCRules(Hhat);
-}
\ No newline at end of file
+	cout << endl << historyG.size() << " strings in the oracle's history, "
+		<< historyG.hitRate() * 100 << "% of lookups answered from it" << endl;
+	historyG.store.flush();
+	delete stream;
+	delete resume;
+}